@@ -1,60 +1,352 @@
 #pragma once
 
+#include <condition_variable>
 #include <functional>
+#include <future>
 #include <thread>
+#include <vector>
 
 #include "board.hpp"
+#include "position_db.hpp"
+#include "solver.hpp"
+#include "transposition_table.hpp"
+
+/// <summary>
+/// Node-reduction techniques layered on top of the plain alpha-beta search.
+/// Each one can be switched off to measure its effect in the bench
+/// </summary>
+struct SearchOptions {
+  int max_depth{12};
+  // Nodes per move, 0 for no limit. The proof-number solver's nodes count
+  // towards it
+  uint64_t max_nodes{};
+  // Largest offset added to each evaluation. The offset follows from the
+  // position's hash, so it is the same every time the position comes up
+  int eval_noise{};
+  size_t hash_size_mb{16};
+  // File backing the transposition table, so a restarted engine starts
+  // with what earlier runs learned. Meant for one engine at a time
+  std::string hash_path;
+  // Per-iteration and summary log lines; servers running many games turn
+  // them off
+  bool log_search{true};
+
+  bool use_pvs{true};
+  bool use_aspiration{true};
+  bool use_lmr{true};
+
+  int aspiration_min_depth{4};
+  int aspiration_window{20};
+
+  // Every move is quiet in Corner Pawns, so reductions kick in early
+  int lmr_min_depth{3};
+  int lmr_min_move{3};
+  double lmr_base{0.75};
+  double lmr_divisor{2.25};
+
+  // Position database used as an opening book; moves need enough games
+  // behind them before they are played without searching
+  std::string book_path;
+  int book_min_games{8};
+
+  // Network file replacing the hand-written evaluation when set
+  std::string nnue_path;
+
+  // Time kept back from every move for passing the result on, so that
+  // replies arrive within the movetime or clock the caller gave
+  int move_overhead_ms{10};
+
+  // Proof-number solver tried before searching once at most this many pawns
+  // stand outside their target corners. It gets the soft time limit at most
+  bool use_solver{true};
+  int solver_max_pawns{6};
+  int solver_max_nodes{200000};
+  size_t solver_hash_size_mb{16};
+};
+
+/// <summary>
+/// Per-search limits and analysis settings. A zero limit means "not
+/// limited": depth and nodes then fall back to SearchOptions
+/// </summary>
+struct SearchLimits {
+  int depth{};
+  // Time for this move, or with a clock the most it may take
+  std::chrono::milliseconds movetime{};
+  // Number of best root moves reported, each with its own score and line
+  int multi_pv{1};
+  // Remaining game time and increment per move of each side, indexed by
+  // get_color_index(). The search budgets the side to move's clock
+  std::array<std::chrono::milliseconds, 2> clock{};
+  std::array<std::chrono::milliseconds, 2> increment{};
+  // Moves until the clock is topped up again, 0 for sudden death
+  int moves_to_go{};
+  // Falls back to SearchOptions::max_nodes
+  uint64_t nodes{};
+
+  [[nodiscard]] bool has_clock(PieceColor color) const {
+    return clock[get_color_index(color)].count() != 0;
+  }
+};
+
+/// <summary>
+/// Playing strength presets. Weaker levels search fewer nodes with a noisier
+/// evaluation, so they use less CPU rather than wait
+/// </summary>
+enum class Difficulty : uint8_t { Easy, Medium, Hard, Max };
+
+struct DifficultyPreset {
+  std::string_view name;
+  uint64_t max_nodes;
+  int eval_noise;
+};
+
+// Indexed by the Difficulty value
+inline constexpr std::array k_difficulty_presets{
+    DifficultyPreset{"easy", 2'000, 60},
+    DifficultyPreset{"medium", 20'000, 20},
+    DifficultyPreset{"hard", 200'000, 5},
+    DifficultyPreset{"max", 0, 0},
+};
+
+inline void apply_difficulty(SearchOptions& options, Difficulty difficulty) {
+  const DifficultyPreset& preset{
+      k_difficulty_presets[to_underlying(difficulty)]};
+  options.max_nodes = preset.max_nodes;
+  options.eval_noise = preset.eval_noise;
+}
+
+/// <summary>
+/// Counters collected over one search. Filled in by the searching thread and
+/// logged once the search is over
+/// </summary>
+struct SearchStats {
+  static constexpr int k_max_iterations{64};
+
+  uint64_t nodes{};
+  uint64_t solver_nodes{};
+  uint64_t tt_probes{};
+  uint64_t tt_hits{};
+  uint64_t fail_highs{};
+  uint64_t fail_highs_first{};
+  int depth{};
+  int seldepth{};
+  double elapsed_ms{};
+  std::array<uint64_t, k_max_iterations> iteration_nodes{};
+  std::array<double, k_max_iterations> iteration_ms{};
+
+  [[nodiscard]] double get_nps() const;
+  [[nodiscard]] double get_hash_hit_rate() const;
+  /// <summary>
+  /// Effective branching factor: nodes of the last iteration divided by the
+  /// nodes of the one before it
+  /// </summary>
+  [[nodiscard]] double get_branching_factor() const;
+  /// <summary>
+  /// Share of beta cutoffs produced by the first move searched, a measure of
+  /// move ordering quality
+  /// </summary>
+  [[nodiscard]] double get_first_move_cutoff_rate() const;
+
+  void log_summary() const;
+};
+
+/// <summary>
+/// A root move with its score and the moves the search expects to follow
+/// </summary>
+struct PvLine {
+  int score{};
+  std::vector<Move> moves;
+};
+
+struct SearchResult {
+  Move best_move;
+  int score{};
+  SearchStats stats;
+  bool is_book_move{};
+  // Best line first, SearchLimits::multi_pv of them at most. Empty for book
+  // moves
+  std::vector<PvLine> lines;
+};
 
 class AI {
-  // clang-format off
-  static constexpr std::array wBase{
-    62,  67,  75,  78,  82,  90,  95, 100,
-    60,  63,  68,  75,  79,  85,  90,  95,
-    55,  60,  64,  69,  75,  80,  85,  90,
-    50,  55,  60,  65,  70,  75,  79,  82,
-    45,  50,  55,  60,  65,  69,  75,  78,
-    40,  45,  50,  55,  60,  64,  68,  75,
-    35,  40,  45,  50,  55,  60,  63,  67,
-    30,  35,  40,  45,  50,  55,  60,  62
-  };
-  static constexpr std::array bBase{
-    62,  60, 55, 50, 45, 40, 35, 30,
-    67,  63, 60, 55, 50, 45, 40, 35,
-    75,  68, 64, 60, 55, 50, 45, 40,
-    78,  75, 69, 65, 60, 55, 50, 45,
-    82,  79, 75, 70, 65, 60, 55, 50,
-    90,  85, 80, 75, 69, 64, 60, 55,
-    95,  90, 85, 79, 75, 68, 63, 60,
-    100, 95, 90, 82, 78, 75, 67, 62
-  };
-  // clang-format on
+  static constexpr int k_max_ply{128};
+  // Moves the rest of the clock is shared by when the caller doesn't say
+  static constexpr int k_default_moves_to_go{30};
+  static constexpr int k_infinity{32000};
+  static constexpr int k_win{30000};
+  static constexpr int k_win_bound{k_win - k_max_ply};
 
  public:
-  AI() : worker_{std::bind_front(&AI::run, this)} {
-    LOG("AI", "Thread started");
+  explicit AI(const SearchOptions& options = {})
+      : options_{options},
+        tt_{options.hash_size_mb, options.hash_path},
+        solver_{options.solver_hash_size_mb},
+        move_stack_(k_max_ply) {
+    init_reductions();
+    if (!options_.book_path.empty()) {
+      book_.open(options_.book_path);
+    }
+    if (!options_.nnue_path.empty()) {
+      nnue_.load(options_.nnue_path);
+    }
   }
 
-  void think(const Board& board, const std::vector<CornerTile>& blackBase,
-             const std::vector<CornerTile>& whiteBase);
+  ~AI() { stop(); }
+
+  AI(const AI&) = delete;
+  AI& operator=(const AI&) = delete;
+
+  AI(AI&&) = delete;
+  AI& operator=(AI&&) = delete;
 
-  Move get_best_move();
-  [[nodiscard]] bool is_thinking() const { return thinking_; }
-  [[nodiscard]] bool has_found_move() const { return found_move_; }
+  /// <summary>
+  /// Hands a copy of the board to the worker thread, which is started on the
+  /// first call. The returned future becomes ready exactly once, when the
+  /// search is over
+  /// </summary>
+  std::future<SearchResult> think(const Board& board,
+                                  const SearchLimits& limits = {});
+
+  /// <summary>
+  /// Searches the given position on the calling thread. Used by the bench,
+  /// the engine service and other tooling that bring their own threads
+  /// </summary>
+  SearchResult find_best_move(const Board& board,
+                              const SearchLimits& limits = {});
+  /// <summary>
+  /// Like find_best_move, but a stop() that came before the call still
+  /// applies, so it cannot be lost while the search waits in a queue. The
+  /// caller owns the stop request: nothing clears it here
+  /// </summary>
+  SearchResult find_best_move_unless_stopped(const Board& board,
+                                             const SearchLimits& limits = {});
+
+  /// <summary>
+  /// Makes the running search return as soon as possible with the best move
+  /// of the last completed iteration
+  /// </summary>
+  void stop() { stop_requested_ = true; }
+
+  /// <summary>
+  /// Forgets everything learned in previous searches, including the
+  /// predicted continuation
+  /// </summary>
+  void clear();
+
+  /// <summary>
+  /// Takes effect with the next search; only call it while none is running
+  /// </summary>
+  void set_difficulty(Difficulty difficulty) {
+    const int eval_noise{options_.eval_noise};
+    apply_difficulty(options_, difficulty);
+    if (options_.eval_noise != eval_noise) {
+      // Table entries were scored with the other noise
+      clear();
+    }
+  }
+
+  /// <summary>
+  /// Snapshot and warm start of the transposition table. Only call these
+  /// while no search is running
+  /// </summary>
+  bool save_hash(const std::string& path) const { return tt_.save(path); }
+  bool load_hash(const std::string& path) { return tt_.load(path); }
+
+  /// <summary>
+  /// Statistics of the last finished search
+  /// </summary>
+  [[nodiscard]] const SearchStats& get_stats() const { return stats_; }
 
  private:
   void run(const std::stop_token& stop_token);
+  void set_board(const Board& board);
+
+  SearchResult search();
+  /// <summary>
+  /// One root search with an aspiration window around the score the line
+  /// had in the previous iteration
+  /// </summary>
+  int search_root(int depth, int previous_score);
+  /// <summary>
+  /// Turns the limits into the soft limit, past which no new iteration
+  /// starts, and the hard limit that aborts the tree walk
+  /// </summary>
+  void init_time_limits();
+  /// <summary>
+  /// Checked between iterations. A best move that has held for several
+  /// iterations stops the search early, one that just changed extends it
+  /// up to the hard limit
+  /// </summary>
+  [[nodiscard]] bool is_soft_limit_reached(int stable_iterations) const;
+  [[nodiscard]] bool should_stop() const;
+  // The node functions are instantiated per side to move, so color-dependent
+  // tables and tests fold into constants; search_root() picks the instance
+  template <PieceColor Us>
+  int negamax(int depth, int ply, int alpha, int beta, bool is_pv);
+  /// <summary>
+  /// Follows the transposition table from the root move, checking every
+  /// move's legality since entries may have been replaced
+  /// </summary>
+  std::vector<Move> extract_pv(Move move, int max_length);
+  /// <summary>
+  /// Remembers the position after the best line's first two moves, so that
+  /// the next search can tell whether the opponent played the reply the
+  /// line expected
+  /// </summary>
+  void predict(const PvLine& line, int depth);
+  template <PieceColor Us>
+  [[nodiscard]] int evaluate() const;
+
+  void init_reductions();
+  template <PieceColor Us>
+  void order_moves(Moves& moves, Move tt_move = {}, int ply = 0) const;
+  template <PieceColor Us>
+  void update_quiet_stats(Move move, int depth, int ply);
 
-  void search();
+  SearchOptions options_;
+  TranspositionTable tt_;
+  ProofSolver solver_;
+  PositionDb book_;
+  Nnue nnue_;
+  std::array<std::array<int, 64>, 64> reductions_{};
+  std::array<std::array<std::array<int, 64>, 64>, 2> history_{};
+  std::array<std::array<Move, 2>, k_max_ply> killers_{};
+  // Move list of every ply, allocated once with the AI and so owned by the
+  // one thread searching with it. Nodes neither allocate nor clear a list
+  // on the stack
+  std::vector<Moves> move_stack_;
+  SearchStats stats_;
 
-  void order_moves(Moves& moves) const;
+  SearchLimits limits_;
+  std::chrono::steady_clock::time_point start_time_;
+  // Zero when the search may visit any number of nodes
+  uint64_t node_limit_{};
+  // Zero when the search has no time limit. Microseconds, so that a clock
+  // shared by many moves does not round down to no limit at all
+  std::chrono::microseconds soft_limit_{};
+  std::chrono::microseconds hard_limit_{};
+  std::atomic<bool> stop_requested_;
+  bool aborted_{};
 
   Move best_move_;
+  // Best move of the last completed root search
+  Move root_best_move_;
+  // Root moves of the lines already found in the current iteration
+  std::vector<Move> excluded_root_moves_;
+  // Position the last search expected to be asked about next, the depth
+  // it was searched to there (0 when there is none) and the move expected
+  uint64_t predicted_hash_{};
+  int predicted_depth_{};
+  Move predicted_move_;
   Board board_;
-  std::vector<CornerTile> blackBase_;
-  std::vector<CornerTile> whiteBase_;
 
-  std::atomic<bool> thinking_;
-  std::atomic<bool> found_move_;
+  // Hand-off between think() and the worker thread
+  std::mutex job_mutex_;
+  std::condition_variable_any job_condition_;
+  Board job_board_;
+  SearchLimits job_limits_;
+  std::promise<SearchResult> job_promise_;
+  bool has_job_{};
 
   std::jthread worker_;
 };
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+/// <summary>
+/// Heap allocations made by the calling thread so far. Debug builds replace
+/// the global operator new to count them; release builds keep the standard
+/// allocator and always report zero
+/// </summary>
+[[nodiscard]] uint64_t get_thread_allocations();
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+// Attack sets of the chess piece types, bit n standing for tile n with tile
+// 0 being a1. Knights and kings read tables built at compile time. Bishops,
+// rooks and queens index per-tile tables by the occupancy of their rays:
+// with a magic multiply, or with PEXT when the build targets BMI2.
+
+namespace attacks_detail {
+// Row and column deltas
+using Offsets = std::array<std::array<int, 2>, 8>;
+
+constexpr Offsets k_knight_offsets{
+    {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}}};
+constexpr Offsets k_king_offsets{
+    {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}}};
+
+constexpr std::array<uint64_t, 64> make_leaper_attacks(const Offsets& offsets) {
+  std::array<uint64_t, 64> attacks{};
+  for (int tile = 0; tile < 64; tile++) {
+    for (const auto& [rows, columns] : offsets) {
+      const int row{tile / 8 + rows};
+      const int column{tile % 8 + columns};
+      if (0 <= row && row < 8 && 0 <= column && column < 8) {
+        attacks[tile] |= uint64_t{1}
+                         << static_cast<unsigned>(row * 8 + column);
+      }
+    }
+  }
+  return attacks;
+}
+}  // namespace attacks_detail
+
+inline constexpr std::array<uint64_t, 64> k_knight_attacks{
+    attacks_detail::make_leaper_attacks(attacks_detail::k_knight_offsets)};
+inline constexpr std::array<uint64_t, 64> k_king_attacks{
+    attacks_detail::make_leaper_attacks(attacks_detail::k_king_offsets)};
+
+struct SliderMagic {
+  // Ray tiles whose occupancy matters, i.e. without the board edge
+  uint64_t mask{};
+  uint64_t magic{};
+  unsigned shift{};
+  // Into SliderTables::attacks
+  size_t offset{};
+
+  [[nodiscard]] size_t get_index(uint64_t occupied) const {
+#ifdef __BMI2__
+    return offset + _pext_u64(occupied, mask);
+#else
+    return offset + (((occupied & mask) * magic) >> shift);
+#endif
+  }
+};
+
+struct SliderTables {
+  std::array<SliderMagic, 64> bishops;
+  std::array<SliderMagic, 64> rooks;
+  std::vector<uint64_t> attacks;
+};
+
+/// <summary>
+/// Fills the tables, searching for magics with a fixed seed where the
+/// built-in ones do not fit
+/// </summary>
+SliderTables make_slider_tables();
+
+/// <summary>
+/// Built on first use, so games without sliding pieces never pay for it
+/// </summary>
+inline const SliderTables& get_slider_tables() {
+  static const SliderTables tables{make_slider_tables()};
+  return tables;
+}
+
+inline uint64_t get_bishop_attacks(int tile, uint64_t occupied) {
+  const SliderTables& tables{get_slider_tables()};
+  return tables.attacks[tables.bishops[tile].get_index(occupied)];
+}
+
+inline uint64_t get_rook_attacks(int tile, uint64_t occupied) {
+  const SliderTables& tables{get_slider_tables()};
+  return tables.attacks[tables.rooks[tile].get_index(occupied)];
+}
+
+inline uint64_t get_queen_attacks(int tile, uint64_t occupied) {
+  return get_bishop_attacks(tile, occupied) | get_rook_attacks(tile, occupied);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "board.hpp"
+#include "simd.hpp"
+
+/// <summary>
+/// Many unrelated positions in structure-of-arrays layout: slot s of every
+/// position is stored contiguously, so one vector load fetches the tiles of
+/// 8 or 16 positions at once
+/// </summary>
+class PositionBatch {
+ public:
+  static constexpr size_t k_max_pawns{9};
+  // Tile stored in unused slots; it maps to zero in every table
+  static constexpr int32_t k_no_pawn{64};
+
+  using Slots = std::array<std::vector<int32_t>, k_max_pawns>;
+
+  void clear();
+  void reserve(size_t size);
+  /// <summary>
+  /// Appends the position. Fails if a side has more than k_max_pawns pawns
+  /// </summary>
+  bool add(const Board& board);
+
+  [[nodiscard]] size_t get_size() const { return signs_.size(); }
+  [[nodiscard]] const Slots& get_white_tiles() const { return white_tiles_; }
+  [[nodiscard]] const Slots& get_black_tiles() const { return black_tiles_; }
+  /// <summary>
+  /// +1 when White is to move, -1 when Black is
+  /// </summary>
+  [[nodiscard]] const std::vector<int32_t>& get_signs() const {
+    return signs_;
+  }
+
+ private:
+  Slots white_tiles_;
+  Slots black_tiles_;
+  std::vector<int32_t> signs_;
+};
+
+/// <summary>
+/// Writes evaluate() of every position in the batch to scores, which must
+/// hold at least batch.get_size() values
+/// </summary>
+void evaluate_batch(const PositionBatch& batch, std::span<int32_t> scores,
+                    SimdLevel level = get_simd_level());
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "ai.hpp"
+
+inline constexpr int k_bench_depth{8};
+
+/// <summary>
+/// Searches a fixed set of positions with every search feature toggled on
+/// and off and prints node counts and timings relative to plain alpha-beta,
+/// followed by the cost of multi-PV, batch evaluation throughput per SIMD
+/// level and the cost of incremental NNUE updates
+/// </summary>
+void run_bench(std::ostream& out, int depth = k_bench_depth);
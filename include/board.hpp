@@ -1,9 +1,12 @@
 #pragma once
 
-#include <mutex>
+#include <bit>
 #include <chrono>
 #include <iostream>
+#include <optional>
+#include <string>
 
+#include "nnue.hpp"
 #include "piece.hpp"
 #include "vector"
 
@@ -23,27 +26,124 @@ constexpr int get_tile_column(int tile) {
 struct Move {
   int tile{-1};
   int target{-1};
+
+  bool operator==(const Move&) const = default;
 };
 
+/// <summary>
+/// Formats the move in coordinate notation, e.g. "f3f4"
+/// </summary>
+std::string move_to_string(Move move);
+std::optional<Move> parse_move(std::string_view text);
+
+// A jump keeps both the row and the column parity, so a pawn's chains stay
+// within 16 tiles: at most 15 jumps and 4 steps. No piece has more moves
+// than a centralised queen's 27, and load_fen() accepts at most
+// k_max_pieces_per_side pieces per side, so a side has at most 14 * 27 = 378
+inline constexpr int k_max_pieces_per_side{14};
+inline constexpr int k_max_moves{384};
+static_assert(k_max_pieces_per_side * 27 <= k_max_moves);
+
 struct Moves {
   int size{};
-  std::array<Move, 256> data{};
+  std::array<Move, k_max_moves> data{};
 };
 
-struct CornerTile {
-  CornerTile(const int& tile, const bool occupied) {
-    this->tile = tile;
-    this->occupied = occupied;
+// Step directions in the order the move generators try them
+enum class Direction : uint8_t { South, North, West, East };
+inline constexpr std::array<int, 4> k_direction_offsets{-8, 8, -1, 1};
+
+inline constexpr uint64_t k_file_a{0x0101010101010101ULL};
+inline constexpr uint64_t k_file_h{k_file_a << 7U};
+
+/// <summary>
+/// Every step of one side as a set: one bitboard of target tiles per
+/// direction, bit n standing for tile n. A target's source is the target
+/// minus the direction's offset
+/// </summary>
+struct StepTargets {
+  std::array<uint64_t, 4> targets{};
+
+  [[nodiscard]] int count() const {
+    return std::popcount(targets[0]) + std::popcount(targets[1]) +
+           std::popcount(targets[2]) + std::popcount(targets[3]);
+  }
+  [[nodiscard]] bool is_empty() const {
+    return (targets[0] | targets[1] | targets[2] | targets[3]) == 0;
+  }
+
+  /// <summary>
+  /// Calls function(move) for every step, direction by direction, without
+  /// building a list
+  /// </summary>
+  template <typename Function>
+  void for_each(Function&& function) const {
+    for (int direction = 0; direction < 4; direction++) {
+      for (uint64_t set = targets[direction]; set != 0; set &= set - 1) {
+        const int target{std::countr_zero(set)};
+        function(Move{target - k_direction_offsets[direction], target});
+      }
+    }
+  }
+
+  /// <summary>
+  /// Appends the steps ordered by source tile, then direction, the order of
+  /// generate_legal_moves(), which move ordering ties depend on
+  /// </summary>
+  void append_to(Moves& moves) const {
+    uint64_t sources{targets[0] << 8U | targets[1] >> 8U | targets[2] << 1U |
+                     targets[3] >> 1U};
+    for (; sources != 0; sources &= sources - 1) {
+      const int tile{std::countr_zero(sources)};
+      for (int direction = 0; direction < 4; direction++) {
+        const int target{tile + k_direction_offsets[direction]};
+        if (is_valid_tile(target) &&
+            (targets[direction] >> static_cast<unsigned>(target) & 1U) != 0) {
+          moves.data[moves.size++] = {tile, target};
+        }
+      }
+    }
   }
-  int tile;
-  bool occupied;
 };
 
+constexpr StepTargets make_step_targets(uint64_t pawns, uint64_t empty) {
+  return {{pawns >> 8U & empty, pawns << 8U & empty,
+           (pawns & ~k_file_a) >> 1U & empty,
+           (pawns & ~k_file_h) << 1U & empty}};
+}
+
+inline constexpr int k_default_repetition_limit{3};
+
+// Corner each color has to fill, which is where the other color starts
+inline constexpr std::array<int, 9> k_white_target_tiles{56, 48, 49, 57, 40,
+                                                         41, 42, 50, 58};
+inline constexpr std::array<int, 9> k_black_target_tiles{7,  6,  14, 15, 5,
+                                                         13, 21, 22, 23};
+
+constexpr uint64_t make_tile_mask(const std::array<int, 9>& tiles) {
+  uint64_t mask{};
+  for (const int tile : tiles) {
+    mask |= uint64_t{1} << static_cast<unsigned>(tile);
+  }
+  return mask;
+}
+
+template <PieceColor Color>
+constexpr uint64_t get_target_mask() {
+  if constexpr (Color == PieceColor::White) {
+    return make_tile_mask(k_white_target_tiles);
+  } else {
+    return make_tile_mask(k_black_target_tiles);
+  }
+}
+
 class Board {
   struct MoveRecord {
     Move move;
     Piece captured_piece{};
     bool is_in_checkmate_{};
+    bool is_draw_{};
+    int reversible_plies_{};
   };
 
   using Records = std::vector<MoveRecord>;
@@ -57,16 +157,141 @@ class Board {
   Board();
 
   void make_move(Move move);
+  /// <summary>
+  /// Plays the move without any game-end bookkeeping. Meant for search code,
+  /// which detects terminal positions on its own
+  /// </summary>
+  void move(Move move);
   void undo();
 
   void generate_all_legal_moves(Moves& moves, bool only_captures = false);
+  /// <summary>
+  /// Hot-path generator for Us, which has to be the side to move. Pawn steps
+  /// cannot be illegal, so no move is tried on the board
+  /// </summary>
+  template <PieceColor Us>
+  void generate_all_moves(Moves& moves) const {
+    assert(turn_ == Us);
+    const uint64_t pieces{occupancy_[get_color_index(Us)]};
+    const uint64_t pawns{pieces & get_pieces(PieceType::Pawn)};
+    if (jumps_) {
+      append_moves_with_jumps(moves, pawns);
+    } else {
+      get_step_targets<Us>().append_to(moves);
+    }
+    if (pieces != pawns) {
+      append_piece_moves(moves, pieces & ~pawns);
+    }
+  }
+  /// <summary>
+  /// Mask-only test whether the side to move can move at all, cheap enough
+  /// for every search node: pawns just need an empty neighbour
+  /// </summary>
+  template <PieceColor Us>
+  [[nodiscard]] bool has_legal_moves() const {
+    assert(turn_ == Us);
+    return !get_step_targets<Us>().is_empty() || has_other_moves();
+  }
+  [[nodiscard]] bool has_legal_moves() const;
+  [[nodiscard]] int count_legal_moves() const;
+  /// <summary>
+  /// All pawn steps of the given side as target sets, for counting or
+  /// testing moves without listing them. Jumps are not included
+  /// </summary>
+  template <PieceColor Color>
+  [[nodiscard]] StepTargets get_step_targets() const;
+  [[nodiscard]] StepTargets get_step_targets(PieceColor color) const;
+
+  [[nodiscard]] uint64_t get_occupancy(PieceColor color) const {
+    return occupancy_[get_color_index(color)];
+  }
+  [[nodiscard]] uint64_t get_occupancy() const {
+    return occupancy_[0] | occupancy_[1];
+  }
+  /// <summary>
+  /// Tiles of the given piece type, of both colors
+  /// </summary>
+  [[nodiscard]] uint64_t get_pieces(PieceType type) const {
+    return type_occupancy_[to_underlying(type)];
+  }
   void generate_legal_moves(Moves& moves, int tile, bool only_captures = false);
 
   [[nodiscard]] bool is_in_checkmate() const { return is_in_checkmate_; }
+  /// <summary>
+  /// Set by make_move() once the repetition rule ends the game
+  /// </summary>
+  [[nodiscard]] bool is_draw() const { return is_draw_; }
+
+  /// <summary>
+  /// Number of times a position has to occur for the game to end in a draw;
+  /// 0 turns the rule off
+  /// </summary>
+  void set_repetition_limit(int limit) { repetition_limit_ = limit; }
+  [[nodiscard]] int get_repetition_limit() const { return repetition_limit_; }
+  /// <summary>
+  /// Leapfrog variant: besides stepping, a pawn may jump over an adjacent
+  /// piece of either color onto the empty tile behind it, and keep jumping
+  /// from there. Like the repetition limit, survives load_fen()
+  /// </summary>
+  void set_jumps(bool jumps) { jumps_ = jumps; }
+  [[nodiscard]] bool has_jumps() const { return jumps_; }
+  /// <summary>
+  /// Every tile the pawn on the given tile reaches by one or more jumps
+  /// </summary>
+  [[nodiscard]] uint64_t get_jump_targets(int tile) const;
+  /// <summary>
+  /// Whether the repetition rule makes the current position a draw. For
+  /// search code, a single repetition within the last search_plies plies
+  /// already counts, since the side that repeated could keep doing so
+  /// </summary>
+  [[nodiscard]] bool is_repetition_draw(int search_plies = 0) const;
 
   uint64_t perft(int depth);
 
-  void load_fen(std::string_view fen = k_initial_fen);
+  /// <summary>
+  /// Returns how many pieces of the given color already stand in the
+  /// opposite corner
+  /// </summary>
+  [[nodiscard]] int count_in_target(PieceColor color) const;
+  template <PieceColor Color>
+  [[nodiscard]] int count_in_target() const {
+    return std::popcount(occupancy_[get_color_index(Color)] &
+                         get_target_mask<Color>());
+  }
+  /// <summary>
+  /// Whether the color has won by filling the opposite corner
+  /// </summary>
+  template <PieceColor Color>
+  [[nodiscard]] bool is_target_filled() const {
+    return (occupancy_[get_color_index(Color)] & get_target_mask<Color>()) ==
+           get_target_mask<Color>();
+  }
+  [[nodiscard]] uint64_t get_hash() const { return hash_; }
+  /// <summary>
+  /// Hash of the position after the move, without playing it
+  /// </summary>
+  [[nodiscard]] uint64_t get_hash_after(Move move) const;
+
+  /// <summary>
+  /// Attaches a network whose accumulator move() and undo() keep up to date.
+  /// nullptr detaches it
+  /// </summary>
+  void set_nnue(const Nnue* nnue);
+  [[nodiscard]] const NnueAccumulator& get_nnue_accumulator() const {
+    return accumulator_;
+  }
+
+  /// <summary>
+  /// Reads the placement and side to move in one pass. Returns false and
+  /// leaves the board as it was when either is malformed or a side has more
+  /// than k_max_pieces_per_side pieces
+  /// </summary>
+  bool load_fen(std::string_view fen = k_initial_fen);
+  /// <summary>
+  /// Placement and side to move with the remaining fields fixed, so that
+  /// load_fen(to_fen()) reproduces the position and its FEN exactly
+  /// </summary>
+  [[nodiscard]] std::string to_fen() const;
 
   [[nodiscard]] PieceColor get_turn() const { return turn_; }
   /// <summary>
@@ -88,33 +313,88 @@ class Board {
   [[nodiscard]] bool is_piece(int tile, PieceColor color, PieceType type) const { return get_color(tile) == color && get_type(tile) == type; }
   // clang-format on
   [[nodiscard]] const Records& get_records() const { return records_; }
+  /// <summary>
+  /// Makes room for this many more moves, so that a search that plays and
+  /// takes them back never has move() allocate
+  /// </summary>
+  void reserve_moves(int count) {
+    records_.reserve(records_.size() + static_cast<size_t>(count));
+    hash_history_.reserve(hash_history_.size() + static_cast<size_t>(count));
+  }
 
   Board& operator=(const Board& other) {
     if (this != &other) {  // Avoid self-assignment
-      this->blackBase = other.blackBase;
-      this->whiteBase = other.whiteBase;
       this->turn_ = other.turn_;
       this->tiles_ = other.tiles_;
+      this->occupancy_ = other.occupancy_;
+      this->type_occupancy_ = other.type_occupancy_;
       this->is_in_checkmate_ = other.is_in_checkmate_;
+      this->is_draw_ = other.is_draw_;
       this->records_ = other.records_;
+      this->hash_history_ = other.hash_history_;
+      this->reversible_plies_ = other.reversible_plies_;
+      this->repetition_limit_ = other.repetition_limit_;
+      this->jumps_ = other.jumps_;
+      this->hash_ = other.hash_;
+      this->nnue_ = other.nnue_;
+      this->accumulator_ = other.accumulator_;
       // Repeat for all members...
     }
     return *this;
   }
  private:
-  void set_tile(int tile, Piece piece) { tiles_[tile] = piece; }
+  void set_tile(int tile, Piece piece) {
+    const uint64_t bit{uint64_t{1} << static_cast<unsigned>(tile)};
+    if (const Piece old_piece{tiles_[tile]}; old_piece != Piece{}) {
+      occupancy_[get_color_index(get_piece_color(old_piece))] &= ~bit;
+      type_occupancy_[to_underlying(get_piece_type(old_piece))] &= ~bit;
+    }
+    if (piece != Piece{}) {
+      occupancy_[get_color_index(get_piece_color(piece))] |= bit;
+      type_occupancy_[to_underlying(get_piece_type(piece))] |= bit;
+    }
+    tiles_[tile] = piece;
+  }
 
-  void move(Move move);
-  bool has_legal_moves();
+  void append_moves_with_jumps(Moves& moves, uint64_t pawns) const;
+  /// <summary>
+  /// Jumps and non-pawn moves of the side to move, which has_legal_moves()
+  /// only needs to look for once no pawn can step
+  /// </summary>
+  [[nodiscard]] bool has_other_moves() const;
+  /// <summary>
+  /// Tiles the non-pawn piece on the tile attacks, without its own pieces
+  /// </summary>
+  [[nodiscard]] uint64_t get_piece_targets(int tile) const;
+  void append_piece_moves(Moves& moves, uint64_t pieces) const;
 
   void generate_moves(Moves& moves, int tile) const;
 
-  std::vector<CornerTile> blackBase;
-  std::vector<CornerTile> whiteBase;
-  mutable std::mutex score_mutex_;
 
   PieceColor turn_{};
   std::array<Piece, 64> tiles_{};
+  // Tiles taken by each color, indexed by get_color_index()
+  std::array<uint64_t, 2> occupancy_{};
+  // Tiles of each piece type, indexed by the PieceType value
+  std::array<uint64_t, 8> type_occupancy_{};
   bool is_in_checkmate_{};
+  bool is_draw_{};
   Records records_;
+  // Hash of the position before each record
+  std::vector<uint64_t> hash_history_;
+  // Plies since the last move that cannot be taken back, i.e. a capture
+  int reversible_plies_{};
+  int repetition_limit_{k_default_repetition_limit};
+  bool jumps_{};
+  uint64_t hash_{};
+  const Nnue* nnue_{};
+  NnueAccumulator accumulator_{};
 };
+
+template <PieceColor Color>
+StepTargets Board::get_step_targets() const {
+  // Pawns step one tile orthogonally onto an empty one
+  return make_step_targets(
+      occupancy_[get_color_index(Color)] & get_pieces(PieceType::Pawn),
+      ~get_occupancy());
+}
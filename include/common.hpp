@@ -3,7 +3,6 @@
 #include <array>
 #include <chrono>
 #include <filesystem>
-#include <glm/glm.hpp>
 #include <memory>
 #include <stdexcept>
 #include <string>
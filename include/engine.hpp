@@ -0,0 +1,59 @@
+#pragma once
+
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <thread>
+
+#include "ai.hpp"
+#include "board.hpp"
+
+/// <summary>
+/// Line-based text protocol around Board and AI, loosely modelled on UCI:
+///   position startpos|fen <fen> [moves <move>...]
+///   go [depth <n>] [nodes <n>] [movetime <ms>] [multipv <n>]
+///      [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>]
+///   solve [nodes], savehash <file>, loadhash <file>, variant steps|jumps
+///   difficulty easy|medium|hard|max
+///   fen, stop, perft <depth>, bench [depth], new, isready, quit
+/// Searches run on the AI worker, so "stop" can interrupt them
+/// </summary>
+class Engine {
+ public:
+  explicit Engine(std::ostream& out, const SearchOptions& options = {});
+  ~Engine();
+
+  Engine(const Engine&) = delete;
+  Engine& operator=(const Engine&) = delete;
+
+  Engine(Engine&&) = delete;
+  Engine& operator=(Engine&&) = delete;
+
+  /// <summary>
+  /// Executes one protocol line. Returns false once "quit" was received
+  /// </summary>
+  bool execute(std::string_view line);
+
+ private:
+  using Args = std::span<const std::string_view>;
+
+  void handle_position(Args args);
+  void handle_go(Args args);
+  void handle_perft(Args args);
+  void handle_bench(Args args);
+  void handle_solve(Args args);
+  void handle_variant(Args args);
+  void handle_difficulty(Args args);
+  void handle_hash(std::string_view command, Args args);
+
+  void wait_for_search();
+  void send(std::string_view line);
+
+  std::ostream& out_;
+  std::mutex out_mutex_;
+
+  Board board_;
+  AI ai_;
+  std::jthread reporter_;
+};
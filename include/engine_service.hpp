@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "ai.hpp"
+#include "board.hpp"
+#include "thread_pool.hpp"
+
+/// <summary>
+/// Hosts many independent games in one process. Searches don't own threads:
+/// they are queued into a shared ThreadPool and every "go" is bounded by a
+/// time budget that starts counting when the request arrives. Games live
+/// until they are closed or their owner goes away
+/// </summary>
+class EngineService {
+ public:
+  struct Options {
+    // Upper bound for a single "go", queueing time included
+    std::chrono::milliseconds max_movetime{1000};
+    // Default budget for a "go" without movetime
+    std::chrono::milliseconds default_movetime{100};
+    // Every game has its own hash, keep it small
+    size_t hash_size_mb{1};
+    // Only allocated once a game reaches the endgame
+    size_t solver_hash_size_mb{1};
+    size_t max_games{4096};
+  };
+
+  using Reply = std::function<void(std::string)>;
+
+  EngineService(ThreadPool& pool, const Options& options);
+
+  /// <summary>
+  /// Executes one request line: "new", or "<game> position ...",
+  /// "<game> go ...", "<game> difficulty <level>", "<game> close". The reply
+  /// is called exactly once, possibly later and from a pool thread, with a
+  /// line prefixed by the game. A "go" that is still running when its game
+  /// is closed is not answered. Games created by "new" belong to the owner,
+  /// e.g. a connection, until close_games(owner)
+  /// </summary>
+  void execute(std::string_view line, const Reply& reply, uint64_t owner = 0);
+
+  /// <summary>
+  /// Closes every game the owner created and has not closed yet
+  /// </summary>
+  void close_games(uint64_t owner);
+
+  [[nodiscard]] size_t get_game_count() const;
+
+ private:
+  struct Session {
+    Session(const SearchOptions& options, uint64_t owner)
+        : ai{options}, owner{owner} {}
+
+    Board board;
+    AI ai;
+    uint64_t owner;
+    bool is_searching{};
+    // Set by "close", so that a queued search never starts and a running
+    // one stays silent
+    bool is_cancelled{};
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  void go(uint64_t id, const std::shared_ptr<Session>& session,
+          SearchLimits limits, const Reply& reply);
+
+  void create_session(uint64_t owner, const Reply& reply);
+  /// <summary>
+  /// Removes the game and cancels its search. Call with sessions_mutex_ held
+  /// </summary>
+  void close_session(uint64_t id, Session& session);
+  [[nodiscard]] std::shared_ptr<Session> find_session(uint64_t id) const;
+
+  ThreadPool& pool_;
+  Options options_;
+
+  mutable std::mutex sessions_mutex_;
+  // A game being created is reserved with a null session, which counts
+  // towards max_games but is not found yet
+  std::unordered_map<uint64_t, std::shared_ptr<Session>> sessions_;
+  uint64_t next_id_{1};
+};
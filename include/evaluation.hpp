@@ -0,0 +1,59 @@
+#pragma once
+
+#include "board.hpp"
+#include "piece.hpp"
+#include "pst.hpp"
+
+// The game is symmetric under transposing the board and swapping colors:
+// Black's start corner and goal are White's mirrored across the a1-h8
+// diagonal. Black therefore uses White's tables on the transposed tile.
+
+constexpr int transpose_tile(int tile) { return (tile & 7) << 3 | tile >> 3; }
+
+// The Color template parameter folds the transposition away in code that
+// already knows the color
+
+template <PieceColor Color>
+constexpr int get_own_tile(int tile) {
+  if constexpr (Color == PieceColor::White) {
+    return tile;
+  } else {
+    return transpose_tile(tile);
+  }
+}
+
+template <PieceColor Color>
+constexpr int get_pst_value(int tile) {
+  return k_pst[get_own_tile<Color>(tile)];
+}
+
+constexpr int get_pst_value(PieceColor color, int tile) {
+  return color == PieceColor::White ? get_pst_value<PieceColor::White>(tile)
+                                    : get_pst_value<PieceColor::Black>(tile);
+}
+
+/// <summary>
+/// Manhattan distance from the tile to the far end of the target corner
+/// </summary>
+template <PieceColor Color>
+constexpr int get_straggler_distance(int tile) {
+  const int own_tile{get_own_tile<Color>(tile)};
+  return (7 - (own_tile >> 3)) + (own_tile & 7);
+}
+
+constexpr int get_straggler_distance(PieceColor color, int tile) {
+  return color == PieceColor::White
+             ? get_straggler_distance<PieceColor::White>(tile)
+             : get_straggler_distance<PieceColor::Black>(tile);
+}
+
+/// <summary>
+/// Static evaluation from the side to move's point of view: piece-square
+/// values minus a penalty for the furthest-lagging pawn
+/// </summary>
+int evaluate(const Board& board);
+/// <summary>
+/// evaluate() for a search that knows Us is to move
+/// </summary>
+template <PieceColor Us>
+int evaluate(const Board& board);
@@ -5,6 +5,7 @@
 
 #include "ai.hpp"
 #include "board.hpp"
+#include "game_record.hpp"
 #include "renderer.hpp"
 
 inline constexpr glm::vec2 k_window_size{1280.0F, 720.0F};
@@ -68,8 +69,6 @@ class Game {
   [[nodiscard]] bool is_selectable_tile(int tile) const;
 
   Board board_;
-  std::vector<CornerTile> blackBase_;
-  std::vector<CornerTile> whiteBase_;
   Moves selectable_tiles_;
   int selected_tile_{-1};
 
@@ -90,11 +89,25 @@ class Game {
 
   bool is_ai_turn() const { return board_.get_turn() == ai_color_; }
 
-  AI ai_;
+  void start_ai_turn();
+  [[nodiscard]] bool is_ai_thinking() const { return ai_move_.valid(); }
+
+  // Built from recorded games with cornerpawns-positiondb, optional
+  static constexpr std::string_view k_book_path{"book.cpdb"};
+  PositionDb book_;
+  void log_book_moves() const;
+
+  AI ai_{SearchOptions{.book_path = std::string{k_book_path}}};
+  std::future<SearchResult> ai_move_;
   PieceColor ai_color_{};
+  // D cycles through the presets
+  Difficulty difficulty_{Difficulty::Max};
 
 
   bool game_over_{};
+  // Finished games are appended here for books and tuning
+  static constexpr std::string_view k_record_path{"games.cpgr"};
+  GameRecordWriter records_;
 
   Transform calculate_piece_transform(int tile) const;
   static glm::vec3 calculate_tile_position(int tile);
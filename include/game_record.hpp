@@ -0,0 +1,128 @@
+#pragma once
+
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+#include "mapped_file.hpp"
+
+// Game record file layout, all integers little-endian:
+//   file header  "CPGR", uint16 version, uint16 reserved
+//   per game     uint16 move count, uint8 GameResult (bit 7 set for the
+//                leapfrog variant), uint8 FEN length,
+//                FEN bytes (none for the initial position),
+//                one uint16 per move: tile | target << 6
+// A sidecar "<path>.idx" holds the uint64 file offset of every game, so the
+// reader can jump straight to game n.
+
+enum class GameResult : uint8_t { None, WhiteWins, BlackWins, Draw };
+
+struct GameRecord {
+  // Empty for the initial position
+  std::string start_fen;
+  std::vector<Move> moves;
+  GameResult result{};
+  // Leapfrog variant, see Board::set_jumps()
+  bool jumps{};
+};
+
+/// <summary>
+/// Builds the record of the game played on the board so far. The result is
+/// None unless the game is over
+/// </summary>
+GameRecord make_game_record(const Board& board, std::string start_fen = {});
+
+/// <summary>
+/// Replays every finished game in the files and calls visit for each
+/// position from skip_plies on, with the game's score for White: 1 for a
+/// white win, 0 for a black win and 0.5 for a draw. A game ends early at
+/// its first illegal move
+/// </summary>
+bool for_each_position(
+    const std::vector<std::string>& paths, int skip_plies,
+    const std::function<void(const Board&, float)>& visit);
+
+/// <summary>
+/// Whether a move read from a record may be played on the board. Record
+/// files are not trusted, and Board::move() assumes legal moves
+/// </summary>
+bool is_legal_move(Board& board, Move move);
+
+constexpr uint16_t pack_move(Move move) {
+  return static_cast<uint16_t>(move.tile | move.target << 6);
+}
+
+constexpr Move unpack_move(uint16_t packed) {
+  return {packed & 63, packed >> 6 & 63};
+}
+
+/// <summary>
+/// Append-only writer, safe to share between threads
+/// </summary>
+class GameRecordWriter {
+ public:
+  bool open(const std::string& path);
+  bool write(const GameRecord& record);
+  void flush();
+
+  [[nodiscard]] bool is_open() const { return data_.is_open(); }
+
+ private:
+  std::mutex mutex_;
+  std::ofstream data_;
+  std::ofstream index_;
+  uint64_t offset_{};
+  std::string buffer_;
+};
+
+/// <summary>
+/// One game inside a mapped record file. Only valid while the reader lives
+/// </summary>
+class GameView {
+ public:
+  explicit GameView(const std::byte* data) : data_{data} {}
+
+  [[nodiscard]] size_t get_move_count() const;
+  [[nodiscard]] GameResult get_result() const;
+  [[nodiscard]] bool has_jumps() const;
+  [[nodiscard]] std::string_view get_start_fen() const;
+  [[nodiscard]] Move get_move(size_t ply) const;
+
+  /// <summary>
+  /// Sets the game's variant and start position on the board. Returns false
+  /// if the start FEN is malformed
+  /// </summary>
+  bool load_start(Board& board) const;
+
+  /// <summary>
+  /// Sets up the start position and plays the game on the board. Stops and
+  /// returns false at the first illegal move
+  /// </summary>
+  bool replay(Board& board) const;
+
+ private:
+  const std::byte* data_;
+};
+
+class GameRecordReader {
+ public:
+  bool open(const std::string& path);
+
+  [[nodiscard]] size_t get_size() const { return offsets_.size(); }
+  [[nodiscard]] GameView get_game(size_t index) const {
+    return GameView{file_.get_data().data() + offsets_[index]};
+  }
+
+ private:
+  /// <summary>
+  /// Walks the game headers from the given offset, recording every complete
+  /// game. Picks up games the index is missing, e.g. after a crash
+  /// </summary>
+  void scan(uint64_t offset);
+
+  MappedFile file_;
+  std::vector<uint64_t> offsets_;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+/// <summary>
+/// Read-only memory mapping of a whole file
+/// </summary>
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile() { close(); }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  /// <summary>
+  /// Maps the file, replacing any previous mapping. An empty file maps to an
+  /// empty span
+  /// </summary>
+  bool open(const std::string& path);
+  void close();
+
+  [[nodiscard]] bool is_open() const { return is_open_; }
+  [[nodiscard]] std::span<const std::byte> get_data() const {
+    return {data_, size_};
+  }
+
+ private:
+  void swap(MappedFile& other) noexcept;
+
+  const std::byte* data_{};
+  size_t size_{};
+  bool is_open_{};
+#ifdef _WIN32
+  void* file_{};
+  void* mapping_{};
+#endif
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "piece.hpp"
+
+class Board;
+
+// Network shape: 128 inputs (own/opponent pawn on each tile, seen from one
+// side), a hidden layer of k_nnue_hidden clipped-ReLU units computed once per
+// perspective, and a linear output over both perspectives, the side to move
+// first. Black's perspective transposes the board, as in get_pst_value().
+inline constexpr size_t k_nnue_inputs{128};
+inline constexpr size_t k_nnue_hidden{64};
+
+/// <summary>
+/// First-layer sums of one position, one row per perspective. Kept up to date
+/// by Board::move()/undo() once the board has a network attached
+/// </summary>
+struct NnueAccumulator {
+  alignas(64) std::array<std::array<int16_t, k_nnue_hidden>, 2> values;
+};
+
+/// <summary>
+/// Quantized network parameters: int16 first layer, int8 output layer
+/// </summary>
+struct NnueParameters {
+  // Hidden activations are clipped to [0, k_activation_max]
+  static constexpr int k_activation_max{127};
+  // Float output weights are multiplied by this before rounding to int8
+  static constexpr int k_output_weight_scale{64};
+
+  std::array<int16_t, k_nnue_hidden> hidden_biases{};
+  std::vector<std::array<int16_t, k_nnue_hidden>> hidden_weights{
+      k_nnue_inputs};
+  // Side to move's units first, then the opponent's
+  std::array<int8_t, 2 * k_nnue_hidden> output_weights{};
+  int32_t output_bias{};
+  // Score = raw output * output_scale /
+  //         (k_activation_max * k_output_weight_scale)
+  int32_t output_scale{1};
+};
+
+/// <summary>
+/// Evaluator built from weights trained with cornerpawns-nnue-train
+/// </summary>
+class Nnue {
+ public:
+  bool load(const std::string& path);
+  bool save(const std::string& path) const;
+  void set_parameters(NnueParameters parameters);
+  /// <summary>
+  /// Small random weights, only meant for benchmarks
+  /// </summary>
+  void init_random(uint64_t seed);
+
+  [[nodiscard]] bool is_loaded() const { return is_loaded_; }
+
+  void refresh(const Board& board, NnueAccumulator& accumulator) const;
+  void add_piece(NnueAccumulator& accumulator, Piece piece, int tile) const;
+  void remove_piece(NnueAccumulator& accumulator, Piece piece,
+                    int tile) const;
+  /// <summary>
+  /// Moves the piece in both perspectives in a single pass
+  /// </summary>
+  void move_piece(NnueAccumulator& accumulator, Piece piece, int from,
+                  int to) const;
+
+  /// <summary>
+  /// Score from the side to move's point of view, in the units of the
+  /// hand-written evaluation
+  /// </summary>
+  [[nodiscard]] int evaluate(const NnueAccumulator& accumulator,
+                             PieceColor turn) const;
+
+  /// <summary>
+  /// Input index of a pawn of the given color as seen from one side
+  /// </summary>
+  static size_t get_feature(PieceColor perspective, PieceColor color,
+                            int tile);
+
+ private:
+  NnueParameters parameters_;
+  // Output weights widened once so the forward pass can use int16 madd
+  alignas(64) std::array<int16_t, 2 * k_nnue_hidden> output_weights_{};
+  bool is_loaded_{};
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+#include "nnue.hpp"
+
+struct NnueTrainerConfig {
+  std::vector<std::string> record_paths;
+  int epochs{20};
+  size_t batch_size{1024};
+  double learning_rate{0.001};
+  int skip_plies{4};
+  // Evaluation units per logit of the predicted result; cornerpawns-tuner
+  // reports the inverse as its sigmoid scale
+  double eval_scale{50.0};
+  uint64_t seed{1};
+};
+
+/// <summary>
+/// Trains the network in float to predict game results from positions, then
+/// quantizes it to NnueParameters
+/// </summary>
+class NnueTrainer {
+ public:
+  explicit NnueTrainer(NnueTrainerConfig config);
+
+  bool load();
+  /// <summary>
+  /// Runs Adam over shuffled mini-batches. Returns the final mean squared
+  /// error
+  /// </summary>
+  double train();
+  [[nodiscard]] NnueParameters quantize() const;
+
+  [[nodiscard]] size_t get_position_count() const { return results_.size(); }
+  /// <summary>
+  /// Float network score of the board, for checking the quantized one
+  /// </summary>
+  [[nodiscard]] double evaluate(const Board& board) const;
+
+ private:
+  static constexpr size_t k_max_pieces{18};
+  static constexpr size_t k_hidden{k_nnue_hidden};
+
+  struct Parameters {
+    std::vector<std::array<float, k_hidden>> hidden_weights{k_nnue_inputs};
+    std::array<float, k_hidden> hidden_biases{};
+    std::array<float, 2 * k_hidden> output_weights{};
+    float output_bias{};
+  };
+
+  // Input indices of one position, side to move's perspective first
+  struct Sample {
+    std::array<std::array<uint8_t, k_max_pieces>, 2> features;
+    uint8_t count;
+  };
+
+  void add_position(const Board& board, float white_result);
+  static Sample make_sample(const Board& board);
+  /// <summary>
+  /// Forward and backward pass of one sample. Adds the gradient and returns
+  /// the squared error
+  /// </summary>
+  float accumulate_gradient(const Sample& sample, float result,
+                            Parameters& gradient) const;
+  [[nodiscard]] float forward(
+      const Sample& sample,
+      std::array<std::array<float, k_hidden>, 2>& hidden) const;
+  void clip_weights();
+
+  NnueTrainerConfig config_;
+  std::vector<Sample> samples_;
+  // Result from the side to move's point of view
+  std::vector<float> results_;
+  Parameters parameters_;
+  std::mt19937_64 generator_;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/// <summary>
+/// Large page-aligned read-write block: either anonymous memory, placed on
+/// huge pages where the OS grants them, or a shared mapping of a file whose
+/// contents outlive the process
+/// </summary>
+class PageMemory {
+ public:
+  PageMemory() = default;
+  ~PageMemory() { release(); }
+
+  PageMemory(const PageMemory&) = delete;
+  PageMemory& operator=(const PageMemory&) = delete;
+
+  PageMemory(PageMemory&& other) noexcept;
+  PageMemory& operator=(PageMemory&& other) noexcept;
+
+  /// <summary>
+  /// Replaces the block with zeroed anonymous memory
+  /// </summary>
+  bool allocate(size_t size);
+  /// <summary>
+  /// Replaces the block with a mapping of the file, created or resized to
+  /// the given size. Contents already in the file are kept and every write
+  /// goes through to it
+  /// </summary>
+  bool map_file(const std::string& path, size_t size);
+  void release();
+
+  [[nodiscard]] std::byte* get_data() const { return data_; }
+  [[nodiscard]] size_t get_size() const { return size_; }
+  [[nodiscard]] bool is_file_backed() const { return is_file_backed_; }
+  [[nodiscard]] bool has_huge_pages() const { return has_huge_pages_; }
+
+ private:
+  void swap(PageMemory& other) noexcept;
+
+  std::byte* data_{};
+  size_t size_{};
+  bool is_file_backed_{};
+  bool has_huge_pages_{};
+#ifdef _WIN32
+  void* file_{};
+  void* mapping_{};
+#endif
+};
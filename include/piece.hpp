@@ -6,7 +6,13 @@ enum class PieceColor : uint8_t { None, Black = 8, White = 16 };
 
 enum class PieceType : uint8_t {
   None,
-  Pawn
+  Pawn,
+  // Chess pieces for multi-piece variants, moving as in chess
+  Knight,
+  Bishop,
+  Rook,
+  Queen,
+  King
 };
 
 enum class Piece : uint8_t;
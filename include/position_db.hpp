@@ -0,0 +1,75 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+#include "mapped_file.hpp"
+
+// Position database layout, native little-endian:
+//   header   "CPDB", uint32 version, uint64 entry count
+//   entries  PositionStats sorted by (hash, move)
+// The entries are used straight from the mapping, nothing is loaded.
+
+/// <summary>
+/// Aggregated outcome of one move played from one position, from the point
+/// of view of the side to move
+/// </summary>
+struct PositionStats {
+  uint64_t hash;
+  uint16_t move;
+  uint16_t reserved;
+  uint32_t wins;
+  uint32_t draws;
+  uint32_t losses;
+
+  [[nodiscard]] uint32_t get_count() const { return wins + draws + losses; }
+  [[nodiscard]] double get_score() const;
+  [[nodiscard]] Move get_move() const;
+};
+
+struct PositionDbBuildConfig {
+  std::vector<std::string> record_paths;
+  std::string output_path;
+  size_t threads{1};
+  // Only the first plies of every game are indexed
+  int max_plies{40};
+  // Entries a thread collects before sorting them into a run file
+  size_t run_size{size_t{1} << 22};
+};
+
+/// <summary>
+/// Builds a position database from game record files: the threads replay
+/// their share of the games and spill sorted, aggregated runs to disk, which
+/// are then merged into the final table
+/// </summary>
+bool build_position_db(const PositionDbBuildConfig& config);
+
+/// <summary>
+/// Read-only view of a position database file
+/// </summary>
+class PositionDb {
+ public:
+  bool open(const std::string& path);
+
+  [[nodiscard]] bool is_open() const { return file_.is_open(); }
+  [[nodiscard]] size_t get_size() const { return entries_.size(); }
+
+  /// <summary>
+  /// Returns the stats of every move recorded for the position, empty if it
+  /// is unknown
+  /// </summary>
+  [[nodiscard]] std::span<const PositionStats> find(uint64_t hash) const;
+
+  /// <summary>
+  /// Returns the best scoring move played at least min_games times
+  /// </summary>
+  [[nodiscard]] std::optional<Move> pick_move(uint64_t hash,
+                                              uint32_t min_games) const;
+
+ private:
+  MappedFile file_;
+  std::span<const PositionStats> entries_;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ai.hpp"
+#include "board.hpp"
+
+// Parsing shared by the text protocol front ends (engine, engine server)
+
+using ProtocolArgs = std::span<const std::string_view>;
+
+std::vector<std::string_view> split_words(std::string_view line);
+std::optional<int> parse_int(std::string_view text);
+/// <summary>
+/// "easy", "medium", "hard" or "max"
+/// </summary>
+std::optional<Difficulty> parse_difficulty(std::string_view name);
+
+/// <summary>
+/// Applies "startpos|fen <fen> [moves <move>...]" to the board. Returns an
+/// error message if the arguments are malformed or a move is illegal, and
+/// then leaves the board as it was
+/// </summary>
+std::optional<std::string> set_position(Board& board, ProtocolArgs args);
+
+/// <summary>
+/// Parses "[depth <n>] [nodes <n>] [movetime <ms>] [multipv <n>]" pairs and the clock
+/// pairs "wtime", "btime", "winc", "binc" (ms) and "movestogo" into limits.
+/// Returns an error message on a malformed value
+/// </summary>
+std::optional<std::string> parse_limits(ProtocolArgs args,
+                                        SearchLimits& limits);
+
+/// <summary>
+/// Sets one SearchOptions field by name, e.g. ("lmr", "off") or
+/// ("lmr_divisor", "2.5"). ("difficulty", <level>) sets the node budget and
+/// evaluation noise of a preset together. Returns an error message for unknown names or
+/// malformed values
+/// </summary>
+std::optional<std::string> set_search_option(SearchOptions& options,
+                                             std::string_view name,
+                                             std::string_view value);
+
+/// <summary>
+/// True once a corner is full, the side to move is stuck or the repetition
+/// rule declares a draw
+/// </summary>
+bool is_game_over(Board& board);
+
+/// <summary>
+/// One "info ... pv <moves>" line per principal variation, best first
+/// </summary>
+std::string format_info(const SearchResult& result);
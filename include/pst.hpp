@@ -0,0 +1,25 @@
+#pragma once
+
+#include <array>
+
+// Evaluation weights, written by cornerpawns-tuner. Rerun the tuner rather
+// than editing the values by hand.
+// Hand-picked initial values
+
+// Penalty per tile the furthest-lagging pawn still has to travel
+inline constexpr int k_straggler_weight{3};
+
+// Pawn values by tile from White's point of view, tile 0 being a1; Black
+// reads the table transposed, see get_pst_value()
+// clang-format off
+inline constexpr std::array<int, 64> k_pst{
+   62,  60,  55,  50,  45,  40,  35,  30,
+   67,  63,  60,  55,  50,  45,  40,  35,
+   75,  68,  64,  60,  55,  50,  45,  40,
+   78,  75,  69,  65,  60,  55,  50,  45,
+   82,  79,  75,  70,  65,  60,  55,  50,
+   90,  85,  80,  75,  69,  64,  60,  55,
+   95,  90,  85,  79,  75,  68,  63,  60,
+  100,  95,  90,  82,  78,  75,  67,  62,
+};
+// clang-format on
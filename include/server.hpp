@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "engine_service.hpp"
+#include "socket.hpp"
+
+/// <summary>
+/// Serves the EngineService protocol over TCP. A single thread multiplexes
+/// every connection with poll(); replies are written by whichever thread
+/// finishes the request
+/// </summary>
+class Server {
+ public:
+  Server(EngineService& service, Socket listener);
+
+  /// <summary>
+  /// Accepts connections and dispatches their request lines until the
+  /// listening socket fails
+  /// </summary>
+  void run();
+
+ private:
+  struct Connection {
+    Connection(Socket socket, uint64_t id)
+        : socket{std::move(socket)}, id{id} {}
+
+    Socket socket;
+    // Owner of the games the connection creates
+    uint64_t id;
+    std::mutex send_mutex;
+    bool is_open{true};
+    LineBuffer lines;
+  };
+
+  void accept_connection();
+  /// <summary>
+  /// Returns false once the connection should be dropped
+  /// </summary>
+  bool read_connection(const std::shared_ptr<Connection>& connection);
+  /// <summary>
+  /// Also closes the connection's games, which nobody else can reach
+  /// </summary>
+  void close_connection(Connection& connection);
+
+  EngineService& service_;
+  Socket listener_;
+  std::vector<std::shared_ptr<Connection>> connections_;
+  uint64_t next_connection_id_{1};
+};
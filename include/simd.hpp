@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// Runtime instruction set dispatch. Kernels for wider instruction sets are
+// compiled per function with CORNERPAWNS_TARGET and only called once
+// get_simd_level() reports support. Kernel files include <immintrin.h>
+// themselves.
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define CORNERPAWNS_X86
+#ifdef _MSC_VER
+// MSVC accepts any intrinsic without per-function target flags
+#define CORNERPAWNS_TARGET(isa)
+#else
+#define CORNERPAWNS_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+enum class SimdLevel : uint8_t { Scalar, Avx2, Avx512 };
+
+std::string_view to_string(SimdLevel level);
+
+/// <summary>
+/// Best instruction set supported by the running CPU, detected once
+/// </summary>
+SimdLevel get_simd_level();
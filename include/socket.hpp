@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <winsock2.h>
+using NativeSocket = SOCKET;
+inline constexpr NativeSocket k_invalid_socket{INVALID_SOCKET};
+#else
+using NativeSocket = int;
+inline constexpr NativeSocket k_invalid_socket{-1};
+#endif
+
+/// <summary>
+/// Owning wrapper around a blocking TCP socket
+/// </summary>
+class Socket {
+ public:
+  Socket() = default;
+  explicit Socket(NativeSocket handle) : handle_{handle} {}
+  ~Socket() { close(); }
+
+  Socket(const Socket&) = delete;
+  Socket& operator=(const Socket&) = delete;
+
+  Socket(Socket&& other) noexcept : handle_{other.release()} {}
+  Socket& operator=(Socket&& other) noexcept;
+
+  /// <summary>
+  /// Initializes the socket library once per process (a no-op outside
+  /// Windows)
+  /// </summary>
+  static bool init();
+
+  static std::optional<Socket> listen(uint16_t port);
+  static std::optional<Socket> connect(const std::string& host, uint16_t port);
+
+  [[nodiscard]] std::optional<Socket> accept() const;
+  bool send_all(std::string_view data) const;
+  /// <summary>
+  /// Reads whatever is available into the buffer. Returns the byte count,
+  /// zero once the peer closed the connection and -1 on error
+  /// </summary>
+  int receive(char* buffer, int size) const;
+
+  void close();
+
+  [[nodiscard]] bool is_valid() const { return handle_ != k_invalid_socket; }
+  [[nodiscard]] NativeSocket get_handle() const { return handle_; }
+
+ private:
+  NativeSocket release();
+
+  NativeSocket handle_{k_invalid_socket};
+};
+
+/// <summary>
+/// Splits a byte stream into '\n' terminated lines
+/// </summary>
+class LineBuffer {
+ public:
+  void append(std::string_view data) { buffer_ += data; }
+  std::optional<std::string> next_line();
+
+ private:
+  std::string buffer_;
+};
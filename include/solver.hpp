@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "board.hpp"
+
+enum class SolverOutcome : uint8_t {
+  // The side to move can force a win
+  Win,
+  // It cannot: every line ends in a loss or a draw
+  NoWin,
+  // The node budget ran out or the solver was stopped
+  Unknown,
+};
+
+struct SolverResult {
+  SolverOutcome outcome{SolverOutcome::Unknown};
+  // First move of the proof when the outcome is a win
+  Move best_move;
+  uint64_t nodes{};
+};
+
+/// <summary>
+/// Pawns of both sides that still stand outside their target corners, a
+/// measure of how close the game is to its end
+/// </summary>
+int count_pawns_outside_targets(const Board& board);
+
+/// <summary>
+/// Depth-first proof-number search (df-pn) proving or disproving that the
+/// side to move can force a win. Proof and disproof numbers are kept in a
+/// hash table that survives between calls. Any repetition, including one of
+/// a position played before the root, counts as a draw, so proofs never
+/// rely on cycles. Disproofs may depend on the path they were found on, so
+/// only a win is exact
+/// </summary>
+class ProofSolver {
+ public:
+  /// <summary>
+  /// The table and per-ply storage are allocated by the first solve(), so
+  /// an AI that never reaches the endgame pays nothing for them
+  /// </summary>
+  explicit ProofSolver(size_t hash_size_mb = 16)
+      : hash_size_mb_{hash_size_mb} {}
+
+  /// <summary>
+  /// Gives up after max_nodes expansions, or once should_stop returns true;
+  /// it is polled every few thousand nodes
+  /// </summary>
+  SolverResult solve(const Board& board, uint64_t max_nodes,
+                     const std::function<bool()>& should_stop = {});
+  void clear();
+
+ private:
+  static constexpr uint32_t k_infinity{1U << 30};
+  // Bounds the recursion and the per-ply storage
+  static constexpr int k_max_ply{128};
+
+  // Both numbers are for the root side winning: a proof number of 0 means
+  // it wins, a disproof number of 0 that it does not
+  struct Numbers {
+    uint32_t proof{1};
+    uint32_t disproof{1};
+  };
+
+  struct Entry {
+    uint64_t key{};
+    Numbers numbers;
+  };
+
+  // Storage of one search level, kept between nodes so that the recursion
+  // neither grows the stack by kilobytes per ply nor fills it anew
+  struct Frame {
+    Moves moves;
+    std::array<Numbers, k_max_moves> children;
+  };
+
+  static constexpr Numbers k_proven{0, k_infinity};
+  static constexpr Numbers k_disproven{k_infinity, 0};
+
+  Numbers search(Numbers thresholds, int ply);
+  /// <summary>
+  /// Numbers of the position after the move: final for moves that end the
+  /// game, from the table otherwise
+  /// </summary>
+  Numbers evaluate_child(Move move);
+
+  [[nodiscard]] uint64_t get_key() const;
+  [[nodiscard]] Numbers lookup() const;
+  void store(Numbers numbers);
+
+  size_t hash_size_mb_{};
+  std::vector<Entry> entries_;
+  size_t mask_{};
+  std::vector<Frame> frames_;
+
+  Board board_;
+  PieceColor attacker_{};
+  uint64_t nodes_{};
+  uint64_t max_nodes_{};
+  const std::function<bool()>* should_stop_{};
+  bool aborted_{};
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Fixed set of worker threads, one queue per worker. Idle workers steal from
+/// the back of the other queues, so one busy producer can't starve the pool
+/// </summary>
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  explicit ThreadPool(
+      size_t thread_count = std::thread::hardware_concurrency());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ThreadPool(ThreadPool&&) = delete;
+  ThreadPool& operator=(ThreadPool&&) = delete;
+
+  /// <summary>
+  /// Queues the task. Tasks submitted from a worker go to its own queue,
+  /// others are spread round-robin
+  /// </summary>
+  void submit(Task task);
+
+  [[nodiscard]] size_t get_size() const { return threads_.size(); }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void run(const std::stop_token& stop_token, size_t index);
+  bool try_pop(size_t index, Task& task);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::atomic<size_t> next_queue_{};
+  std::atomic<size_t> pending_{};
+
+  std::mutex wake_mutex_;
+  std::condition_variable_any wake_condition_;
+
+  std::vector<std::jthread> threads_;
+};
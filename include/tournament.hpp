@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ai.hpp"
+#include "game_record.hpp"
+
+/// <summary>
+/// Sequential probability ratio test on game results: H0 "engine A is elo0
+/// stronger than B" against H1 "A is elo1 stronger"
+/// </summary>
+struct SprtConfig {
+  double elo0{0.0};
+  double elo1{10.0};
+  double alpha{0.05};
+  double beta{0.05};
+
+  [[nodiscard]] double get_lower_bound() const;
+  [[nodiscard]] double get_upper_bound() const;
+};
+
+struct TournamentConfig {
+  SearchOptions engine_a;
+  SearchOptions engine_b;
+  // A clock in the limits is each side's time for the whole game; the side
+  // whose clock runs out loses
+  SearchLimits limits;
+  // Every opening is played twice with colors swapped
+  std::vector<std::string> openings;
+  int max_games{2000};
+  int max_plies{300};
+  // Occurrences of a position that draw the game, 0 for no repetition rule
+  int repetition_limit{k_default_repetition_limit};
+  // Leapfrog variant, see Board::set_jumps()
+  bool jumps{};
+  size_t threads{1};
+  SprtConfig sprt;
+  // Every finished game is appended to this game record file unless empty
+  std::string record_path;
+};
+
+/// <summary>
+/// Running totals, always from engine A's point of view
+/// </summary>
+struct TournamentResult {
+  int wins{};
+  int draws{};
+  int losses{};
+  uint64_t nodes{};
+  double search_ms{};
+  double wall_ms{};
+  // Games either engine lost by running out of time
+  int time_losses{};
+
+  [[nodiscard]] int get_games() const { return wins + draws + losses; }
+  [[nodiscard]] double get_score() const;
+  [[nodiscard]] double get_elo() const;
+  /// <summary>
+  /// Half-width of the 95% confidence interval of get_elo()
+  /// </summary>
+  [[nodiscard]] double get_elo_error() const;
+  [[nodiscard]] double get_llr(const SprtConfig& sprt) const;
+  [[nodiscard]] double get_nps() const;
+};
+
+/// <summary>
+/// Plays engine A against engine B, one game per thread, until max_games are
+/// played or the SPRT accepts either hypothesis
+/// </summary>
+class Tournament {
+ public:
+  explicit Tournament(TournamentConfig config);
+
+  /// <summary>
+  /// Returns nothing, without playing a game, if an opening is malformed or
+  /// illegal under the configured rules
+  /// </summary>
+  std::optional<TournamentResult> run();
+
+  /// <summary>
+  /// Generates openings by playing random legal plies from the start position,
+  /// returned as protocol position strings ("startpos moves ...")
+  /// </summary>
+  static std::vector<std::string> generate_openings(int count, int plies,
+                                                    uint64_t seed);
+
+ private:
+  enum class Outcome : uint8_t { WinA, Draw, WinB };
+
+  /// <summary>
+  /// Sets up the opening under the configured rules. Returns an error
+  /// message if it cannot be played
+  /// </summary>
+  std::optional<std::string> set_opening(Board& board,
+                                         const std::string& opening) const;
+  void run_worker();
+  Outcome play_game(int game_index, AI& ai_a, AI& ai_b, uint64_t& nodes,
+                    double& search_ms, bool& is_time_loss);
+  [[nodiscard]] bool is_finished() const;
+
+  TournamentConfig config_;
+  std::atomic<int> next_game_{};
+
+  GameRecordWriter records_;
+
+  mutable std::mutex result_mutex_;
+  TournamentResult result_;
+};
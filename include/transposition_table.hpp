@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "board.hpp"
+#include "page_memory.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+enum class Bound : uint8_t { None, Upper, Lower, Exact };
+
+struct TTEntry {
+  uint64_t key{};
+  int16_t score{};
+  int8_t tile{-1};
+  int8_t target{-1};
+  uint8_t depth{};
+  Bound bound{};
+
+  [[nodiscard]] Move get_move() const { return {tile, target}; }
+};
+
+class TranspositionTable {
+ public:
+  /// <summary>
+  /// Allocates the table in memory, or maps it from the file when a path is
+  /// given and mapping succeeds
+  /// </summary>
+  explicit TranspositionTable(size_t size_mb = 16,
+                              const std::string& path = {});
+
+  /// <summary>
+  /// Reallocates the table in memory, dropping all entries
+  /// </summary>
+  void resize(size_t size_mb);
+  /// <summary>
+  /// Backs the table with a file, so everything stored survives restarts.
+  /// Entries left by an earlier run are kept when the file holds a table of
+  /// the same size
+  /// </summary>
+  bool map_file(const std::string& path, size_t size_mb);
+  void clear();
+
+  /// <summary>
+  /// Writes a snapshot of all entries to the file
+  /// </summary>
+  bool save(const std::string& path) const;
+  /// <summary>
+  /// Merges a snapshot into the table, which may differ in size from the
+  /// one that was saved. Deeper entries win where two land on one slot
+  /// </summary>
+  bool load(const std::string& path);
+
+  /// <summary>
+  /// Returns the entry stored for the given key or nullptr on a miss
+  /// </summary>
+  [[nodiscard]] const TTEntry* probe(uint64_t key) const;
+  void store(uint64_t key, int depth, int score, Bound bound, Move move);
+
+  /// <summary>
+  /// Starts loading the slot of the key into the cache ahead of probe()
+  /// </summary>
+  void prefetch(uint64_t key) const {
+    const TTEntry* entry{&entries_[get_index(key)]};
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(reinterpret_cast<const char*>(entry), _MM_HINT_T0);
+#elif defined(__GNUC__)
+    __builtin_prefetch(entry);
+#endif
+  }
+
+  [[nodiscard]] size_t get_entry_count() const { return mask_ + 1; }
+
+ private:
+  [[nodiscard]] size_t get_index(uint64_t key) const { return key & mask_; }
+  static size_t get_entry_count(size_t size_mb);
+  void set_memory(PageMemory memory, size_t offset);
+
+  PageMemory memory_;
+  TTEntry* entries_{};
+  size_t mask_{};
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+
+struct TunerConfig {
+  std::vector<std::string> record_paths;
+  size_t threads{1};
+  int iterations{500};
+  double learning_rate{0.5};
+  // Opening plies come from random openings and say little about the result
+  int skip_plies{4};
+};
+
+/// <summary>
+/// Texel-style tuner: fits the piece-square table and the straggler weight so
+/// that a sigmoid of the evaluation predicts the recorded game results
+/// </summary>
+class Tuner {
+ public:
+  // 64 piece-square values followed by the straggler weight
+  static constexpr size_t k_weight_count{65};
+  using Weights = std::array<double, k_weight_count>;
+
+  explicit Tuner(TunerConfig config);
+
+  /// <summary>
+  /// Replays every finished game and turns its positions into features
+  /// </summary>
+  bool load();
+  /// <summary>
+  /// Picks the sigmoid scale that best fits the current weights
+  /// </summary>
+  void fit_scale();
+  /// <summary>
+  /// Runs Adam for the configured number of iterations. Returns the final
+  /// loss
+  /// </summary>
+  double tune();
+
+  [[nodiscard]] size_t get_position_count() const { return results_.size(); }
+  [[nodiscard]] const Weights& get_weights() const { return weights_; }
+  /// <summary>
+  /// Renders the weights as the contents of pst.hpp
+  /// </summary>
+  [[nodiscard]] std::string generate_header(double loss) const;
+
+ private:
+  void add_position(const Board& board, float result);
+  /// <summary>
+  /// Mean squared error over all positions, split across the threads. Fills
+  /// the gradient with respect to the weights when one is given
+  /// </summary>
+  double compute_loss(const Weights& weights, double scale,
+                      Weights* gradient) const;
+
+  TunerConfig config_;
+  // 64 features per position: the number of white pawns on the tile minus
+  // the number of black pawns on its transposed tile
+  std::vector<int8_t> features_;
+  // Black's straggler distance minus White's
+  std::vector<int8_t> stragglers_;
+  // 1 for a white win, 0 for a black win, 0.5 for a draw
+  std::vector<float> results_;
+  Weights weights_{};
+  double scale_{0.01};
+};
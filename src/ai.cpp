@@ -1,56 +1,649 @@
 #include "ai.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+#include "alloc_counter.hpp"
 #include "board.hpp"
+#include "evaluation.hpp"
 
-void AI::think(const Board& board, const std::vector<CornerTile>& blackBase,
-               const std::vector<CornerTile>& whiteBase) {
-  assert(!thinking_);
-  board_ = board;
-  blackBase_ = blackBase;
-  whiteBase_ = whiteBase;
-  found_move_ = false;
-  thinking_ = true;
+namespace {
+// Mate-like scores are stored relative to the node so they stay valid when
+// the same position is reached at a different ply
+int score_to_tt(int score, int ply, int win_bound) {
+  if (score >= win_bound) {
+    return score + ply;
+  }
+  if (score <= -win_bound) {
+    return score - ply;
+  }
+  return score;
+}
+
+int score_from_tt(int score, int ply, int win_bound) {
+  if (score >= win_bound) {
+    return score - ply;
+  }
+  if (score <= -win_bound) {
+    return score + ply;
+  }
+  return score;
+}
+
+// Evenly spread over [-amplitude, amplitude], taken from the upper hash bits
+// since the table indexes by the lower ones
+int get_eval_noise(uint64_t hash, int amplitude) {
+  const auto range{static_cast<uint64_t>(2 * amplitude + 1)};
+  return static_cast<int>((hash >> 32U) % range) - amplitude;
+}
+}  // namespace
+
+double SearchStats::get_nps() const {
+  return elapsed_ms > 0.0 ? static_cast<double>(nodes) * 1000.0 / elapsed_ms
+                          : 0.0;
+}
+
+double SearchStats::get_hash_hit_rate() const {
+  return tt_probes != 0 ? static_cast<double>(tt_hits) /
+                              static_cast<double>(tt_probes)
+                        : 0.0;
+}
+
+double SearchStats::get_branching_factor() const {
+  if (depth < 2 || iteration_nodes[depth - 2] == 0) {
+    return 0.0;
+  }
+  return static_cast<double>(iteration_nodes[depth - 1]) /
+         static_cast<double>(iteration_nodes[depth - 2]);
 }
 
-Move AI::get_best_move() {
-  assert(found_move_);
-  found_move_ = false;
-  LOGF("AI", "moving from tile {} to tile {}", best_move_.tile, best_move_.target);
-  return best_move_;
+double SearchStats::get_first_move_cutoff_rate() const {
+  return fail_highs != 0 ? static_cast<double>(fail_highs_first) /
+                               static_cast<double>(fail_highs)
+                         : 0.0;
+}
+
+void SearchStats::log_summary() const {
+  LOGF("AI",
+       "depth {} seldepth {} nodes {} time {:.1f} ms nps {:.0f} hash hits "
+       "{:.1f}% ebf {:.2f} first move cutoffs {:.1f}%",
+       depth, seldepth, nodes, elapsed_ms, get_nps(),
+       100.0 * get_hash_hit_rate(), get_branching_factor(),
+       100.0 * get_first_move_cutoff_rate());
+  if (solver_nodes != 0) {
+    LOGF("AI", "solver found no forced win in {} nodes", solver_nodes);
+  }
+  for (int i = 0; i < depth; i++) {
+    LOGF("AI", "iteration {}: {} nodes in {:.1f} ms", i + 1,
+         iteration_nodes[i], iteration_ms[i]);
+  }
+}
+
+std::future<SearchResult> AI::think(const Board& board,
+                                    const SearchLimits& limits) {
+  if (!worker_.joinable()) {
+    worker_ = std::jthread{std::bind_front(&AI::run, this)};
+    LOG("AI", "Thread started");
+  }
+
+  std::future<SearchResult> result;
+  {
+    std::lock_guard<std::mutex> lock(job_mutex_);
+    assert(!has_job_);
+    stop_requested_ = false;
+    job_board_ = board;
+    job_limits_ = limits;
+    job_promise_ = {};
+    result = job_promise_.get_future();
+    has_job_ = true;
+  }
+  job_condition_.notify_one();
+  return result;
+}
+
+SearchResult AI::find_best_move(const Board& board,
+                                const SearchLimits& limits) {
+  stop_requested_ = false;
+  return find_best_move_unless_stopped(board, limits);
+}
+
+SearchResult AI::find_best_move_unless_stopped(const Board& board,
+                                               const SearchLimits& limits) {
+  set_board(board);
+  limits_ = limits;
+  return search();
+}
+
+void AI::clear() {
+  tt_.clear();
+  solver_.clear();
+  history_ = {};
+  killers_ = {};
+  predicted_depth_ = 0;
 }
 
 void AI::run(const std::stop_token& stop_token) {
-  while (!stop_token.stop_requested()) {
-    std::this_thread::sleep_for(1s);
-    if (thinking_ && !found_move_) {
-      search();
-      thinking_ = false;
-      found_move_ = true;
+  while (true) {
+    std::promise<SearchResult> promise;
+    {
+      std::unique_lock<std::mutex> lock(job_mutex_);
+      if (!job_condition_.wait(lock, stop_token,
+                               [this] { return has_job_; })) {
+        break;
+      }
+      set_board(job_board_);
+      limits_ = job_limits_;
+      promise = std::move(job_promise_);
+      has_job_ = false;
     }
+    promise.set_value(search());
   }
   LOG("AI", "Thread stopped");
 }
 
-void AI::search() {
-  Move best_move;
+void AI::set_board(const Board& board) {
+  board_ = board;
+  board_.set_nnue(nnue_.is_loaded() ? &nnue_ : nullptr);
+  board_.reserve_moves(k_max_ply);
+}
+
+SearchResult AI::search() {
+  start_time_ = std::chrono::steady_clock::now();
+  auto elapsed_ms = [this] {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start_time_)
+        .count();
+  };
+  stats_ = {};
+  killers_ = {};
+  aborted_ = false;
+  node_limit_ = limits_.nodes != 0 ? limits_.nodes : options_.max_nodes;
+  init_time_limits();
+
+  // When the opponent answered as expected, the table still holds this
+  // position searched two plies less deep than the last root
+  const int known_depth{
+      board_.get_hash() == predicted_hash_ ? predicted_depth_ : 0};
+  predicted_depth_ = 0;
+
   Moves all_legal_moves;
   board_.generate_all_legal_moves(all_legal_moves);
   assert(all_legal_moves.size != 0);
-  order_moves(all_legal_moves);
+
+  if (book_.is_open()) {
+    const std::optional<Move> book_move{book_.pick_move(
+        board_.get_hash(), static_cast<uint32_t>(options_.book_min_games))};
+    const auto end{all_legal_moves.data.begin() + all_legal_moves.size};
+    // A hash collision could suggest a move that is illegal here
+    if (book_move && std::find(all_legal_moves.data.begin(), end,
+                               *book_move) != end) {
+      stats_.elapsed_ms = elapsed_ms();
+      if (options_.log_search) {
+        LOGF("AI", "book move {}", move_to_string(*book_move));
+      }
+      return {.best_move = *book_move,
+              .stats = stats_,
+              .is_book_move = true,
+              .lines = {}};
+    }
+  }
+
+  if (options_.use_solver && limits_.multi_pv <= 1 &&
+      count_pawns_outside_targets(board_) <= options_.solver_max_pawns) {
+    const auto solver_nodes{static_cast<uint64_t>(options_.solver_max_nodes)};
+    const SolverResult solved{solver_.solve(
+        board_,
+        node_limit_ != 0 ? std::min(solver_nodes, node_limit_) : solver_nodes,
+        [this] {
+          return stop_requested_ ||
+                 (soft_limit_.count() != 0 &&
+                  std::chrono::steady_clock::now() - start_time_ >=
+                      soft_limit_);
+        })};
+    stats_.solver_nodes = solved.nodes;
+    if (solved.outcome == SolverOutcome::Win &&
+        solved.best_move != Move{}) {
+      stats_.elapsed_ms = elapsed_ms();
+      if (options_.log_search) {
+        LOGF("AI", "solver proved a win with {} in {} nodes",
+             move_to_string(solved.best_move), solved.nodes);
+      }
+      return {.best_move = solved.best_move,
+              .score = k_win_bound,
+              .stats = stats_,
+              .is_book_move = false,
+              .lines = {{k_win_bound, {solved.best_move}}}};
+    }
+  }
+
+  if (board_.get_turn() == PieceColor::White) {
+    order_moves<PieceColor::White>(all_legal_moves);
+  } else {
+    order_moves<PieceColor::Black>(all_legal_moves);
+  }
   best_move_ = all_legal_moves.data[0];
+  // Until an iteration completes, the move the line expected is the best
+  // guess
+  if (known_depth > 0) {
+    const auto begin{all_legal_moves.data.begin()};
+    const auto end{begin + all_legal_moves.size};
+    if (std::find(begin, end, predicted_move_) != end) {
+      best_move_ = predicted_move_;
+    }
+  }
+
+  const int line_count{std::clamp(limits_.multi_pv, 1, all_legal_moves.size)};
+  std::vector<PvLine> lines;
+  int score{};
+  const int max_depth{
+      std::min(limits_.depth > 0 ? limits_.depth : options_.max_depth,
+               SearchStats::k_max_iterations)};
+  // Iterations up to the known depth mostly replay the table, but they
+  // still rebuild the killers and PV ordering the deeper ones need; going
+  // straight to the known depth costs more nodes than it saves
+  if (known_depth > 0 && options_.log_search) {
+    LOGF("AI", "predicted position, searched to depth {} before",
+         known_depth);
+  }
+  int stable_iterations{};
+  for (int depth = 1; depth <= max_depth; depth++) {
+    const uint64_t nodes_before{stats_.nodes};
+    const double ms_before{elapsed_ms()};
+
+    // Each further line searches the root without the moves found so far,
+    // reusing everything the earlier lines left in the table
+    std::vector<PvLine> iteration_lines;
+    excluded_root_moves_.clear();
+    for (int line = 0; line < line_count; line++) {
+      const int line_score{search_root(
+          depth, line < static_cast<int>(lines.size()) ? lines[line].score
+                                                       : score)};
+      if (aborted_) {
+        break;
+      }
+      iteration_lines.push_back(
+          {line_score, extract_pv(root_best_move_, depth)});
+      excluded_root_moves_.push_back(root_best_move_);
+    }
+    excluded_root_moves_.clear();
+    // A partial iteration can't be trusted, keep the previous one's lines
+    if (aborted_) {
+      break;
+    }
+    std::ranges::stable_sort(iteration_lines, std::ranges::greater{},
+                             &PvLine::score);
+    lines = std::move(iteration_lines);
+    score = lines[0].score;
+    stable_iterations =
+        best_move_ == lines[0].moves[0] ? stable_iterations + 1 : 0;
+    best_move_ = lines[0].moves[0];
+
+    stats_.depth = depth;
+    stats_.iteration_nodes[depth - 1] = stats_.nodes - nodes_before;
+    stats_.iteration_ms[depth - 1] = elapsed_ms() - ms_before;
+    if (options_.log_search) {
+      LOGF("AI", "depth {} score {} nodes {} move {} -> {}", depth, score,
+           stats_.nodes, best_move_.tile, best_move_.target);
+    }
+
+    if (std::abs(score) >= k_win_bound ||
+        is_soft_limit_reached(stable_iterations)) {
+      break;
+    }
+  }
+  if (lines.empty()) {
+    lines.push_back({score, {best_move_}});
+  }
+  predict(lines[0], stats_.depth);
+
+  stats_.elapsed_ms = elapsed_ms();
+  if (options_.log_search) {
+    stats_.log_summary();
+    LOGF("AI", "moving from tile {} to tile {}", best_move_.tile,
+         best_move_.target);
+  }
+  return {best_move_, score, stats_, false, std::move(lines)};
+}
+
+int AI::search_root(int depth, int previous_score) {
+  int delta{options_.aspiration_window};
+  int alpha{-k_infinity};
+  int beta{k_infinity};
+  if (options_.use_aspiration && depth >= options_.aspiration_min_depth &&
+      std::abs(previous_score) < k_win_bound) {
+    alpha = std::max(previous_score - delta, -k_infinity);
+    beta = std::min(previous_score + delta, k_infinity);
+  }
+
+  while (true) {
+    [[maybe_unused]] const uint64_t allocations{get_thread_allocations()};
+    const int score{
+        board_.get_turn() == PieceColor::White
+            ? negamax<PieceColor::White>(depth, 0, alpha, beta, true)
+            : negamax<PieceColor::Black>(depth, 0, alpha, beta, true)};
+    // The tree walk only uses the move stack and the reserved undo records
+    assert(get_thread_allocations() == allocations);
+    if (aborted_ || (score > alpha && score < beta)) {
+      return score;
+    }
+    if (score <= alpha) {
+      beta = (alpha + beta) / 2;
+      alpha = std::max(score - delta, -k_infinity);
+    } else {
+      beta = std::min(score + delta, k_infinity);
+    }
+    delta *= 2;
+  }
 }
 
-void AI::order_moves(Moves& moves) const {
-  const auto& base_table =
-      (board_.get_turn() == PieceColor::White) ? bBase : wBase;
+std::vector<Move> AI::extract_pv(Move move, int max_length) {
+  std::vector<Move> pv{move};
+  board_.move(move);
+  while (static_cast<int>(pv.size()) < max_length &&
+         board_.count_in_target(get_opposite_color(board_.get_turn())) < 9 &&
+         !board_.is_repetition_draw(static_cast<int>(pv.size()))) {
+    const TTEntry* entry{tt_.probe(board_.get_hash())};
+    if (entry == nullptr || !is_valid_tile(entry->tile)) {
+      break;
+    }
+    const Move next{entry->get_move()};
+    Moves moves;
+    board_.generate_legal_moves(moves, next.tile);
+    const auto end{moves.data.begin() + moves.size};
+    if (std::find(moves.data.begin(), end, next) == end) {
+      break;
+    }
+    pv.push_back(next);
+    board_.move(next);
+  }
+  for (size_t i = 0; i < pv.size(); i++) {
+    board_.undo();
+  }
+  return pv;
+}
+
+void AI::predict(const PvLine& line, int depth) {
+  if (line.moves.size() < 2 || depth < 3) {
+    return;
+  }
+  board_.move(line.moves[0]);
+  board_.move(line.moves[1]);
+  predicted_hash_ = board_.get_hash();
+  board_.undo();
+  board_.undo();
+  predicted_depth_ = depth - 2;
+  predicted_move_ = line.moves.size() > 2 ? line.moves[2] : Move{};
+}
+
+void AI::init_time_limits() {
+  using std::chrono::microseconds;
+  const microseconds overhead{std::chrono::milliseconds{
+      options_.move_overhead_ms}};
+  soft_limit_ = {};
+  hard_limit_ = {};
+  if (limits_.has_clock(board_.get_turn())) {
+    const size_t index{get_color_index(board_.get_turn())};
+    const microseconds clock{limits_.clock[index]};
+    // A nearly empty clock is better spent on moving than on the overhead
+    const microseconds available{std::max(clock - overhead, clock / 4)};
+    const int moves_to_go{limits_.moves_to_go > 0 ? limits_.moves_to_go
+                                                  : k_default_moves_to_go};
+    // The increment arrives after every move, so most of it can be spent
+    soft_limit_ = std::min(
+        available / moves_to_go +
+            microseconds{limits_.increment[index]} * 3 / 4,
+        available);
+    hard_limit_ = std::min(soft_limit_ * 4, available);
+  }
+  if (limits_.movetime.count() != 0) {
+    const microseconds movetime{std::max(microseconds{limits_.movetime} -
+                                             overhead,
+                                         microseconds{limits_.movetime} / 4)};
+    hard_limit_ = hard_limit_.count() != 0 ? std::min(hard_limit_, movetime)
+                                           : movetime;
+    // Each iteration takes several times as long as the one before, so one
+    // started after half the time would hardly ever finish
+    soft_limit_ = soft_limit_.count() != 0 ? std::min(soft_limit_, movetime)
+                                           : movetime / 2;
+  }
+}
+
+bool AI::is_soft_limit_reached(int stable_iterations) const {
+  if (soft_limit_.count() == 0) {
+    return false;
+  }
+  double scale{1.0};
+  if (stable_iterations == 0) {
+    scale = 1.5;
+  } else if (stable_iterations >= 3) {
+    scale = 0.6;
+  }
+  const std::chrono::duration<double, std::micro> limit{
+      std::min(static_cast<double>(soft_limit_.count()) * scale,
+               static_cast<double>(hard_limit_.count()))};
+  return std::chrono::steady_clock::now() - start_time_ >= limit;
+}
+
+bool AI::should_stop() const {
+  if (stop_requested_) {
+    return true;
+  }
+  return hard_limit_.count() != 0 &&
+         std::chrono::steady_clock::now() - start_time_ >= hard_limit_;
+}
+
+template <PieceColor Us>
+int AI::negamax(int depth, int ply, int alpha, int beta, bool is_pv) {
+  constexpr PieceColor k_them{get_opposite_color(Us)};
+  assert(board_.get_turn() == Us);
+  // The node limit is checked at every node, so a budget gives the same
+  // search on every machine
+  if (((stats_.nodes & 1023U) == 0 && should_stop()) ||
+      (node_limit_ != 0 && stats_.nodes + stats_.solver_nodes >= node_limit_)) {
+    aborted_ = true;
+  }
+  if (aborted_) {
+    return 0;
+  }
+  stats_.nodes++;
+  stats_.seldepth = std::max(stats_.seldepth, ply);
+
+  // The side that just moved may have filled the opposite corner or left
+  // this side without a move, both of which end the game. The masks make
+  // this cheap enough to test before every static evaluation
+  if (ply > 0 && (board_.is_target_filled<k_them>() ||
+                  !board_.has_legal_moves<Us>())) {
+    return -k_win + ply;
+  }
+  if (ply > 0 && board_.is_repetition_draw(ply)) {
+    return 0;
+  }
+  if (ply >= k_max_ply - 1) {
+    return evaluate<Us>();
+  }
+
+  const uint64_t hash{board_.get_hash()};
+  Move tt_move{};
+  stats_.tt_probes++;
+  if (const TTEntry* entry = tt_.probe(hash); entry != nullptr) {
+    stats_.tt_hits++;
+    tt_move = entry->get_move();
+    const int tt_score{score_from_tt(entry->score, ply, k_win_bound)};
+    if (!is_pv && ply > 0 && entry->depth >= depth &&
+        (entry->bound == Bound::Exact ||
+         (entry->bound == Bound::Lower && tt_score >= beta) ||
+         (entry->bound == Bound::Upper && tt_score <= alpha))) {
+      return tt_score;
+    }
+  }
+
+  if (depth <= 0) {
+    return evaluate<Us>();
+  }
+
+  Moves& moves{move_stack_[ply]};
+  moves.size = 0;
+  board_.generate_all_moves<Us>(moves);
+  if (moves.size == 0) {
+    return -k_win + ply;
+  }
+  if (ply == 0 && !excluded_root_moves_.empty()) {
+    const auto end{std::remove_if(
+        moves.data.begin(), moves.data.begin() + moves.size,
+        [this](Move move) {
+          return std::ranges::find(excluded_root_moves_, move) !=
+                 excluded_root_moves_.end();
+        })};
+    moves.size = static_cast<int>(end - moves.data.begin());
+  }
+  order_moves<Us>(moves, tt_move, ply);
+
+  const int alpha_orig{alpha};
+  int best_score{-k_infinity};
+  Move best_move{};
+  for (int i = 0; i < moves.size; i++) {
+    const Move move{moves.data[i]};
+    // The child's slot loads while the move is being made
+    tt_.prefetch(board_.get_hash_after(move));
+    board_.move(move);
+
+    int score{};
+    if (i == 0) {
+      score = -negamax<k_them>(depth - 1, ply + 1, -beta, -alpha, is_pv);
+    } else {
+      int reduction{};
+      if (options_.use_lmr && depth >= options_.lmr_min_depth &&
+          i >= options_.lmr_min_move) {
+        reduction = reductions_[std::min(depth, 63)][std::min(i, 63)];
+        if (is_pv) {
+          reduction--;
+        }
+        reduction = std::clamp(reduction, 0, depth - 2);
+      }
+
+      if (options_.use_pvs) {
+        score = -negamax<k_them>(depth - 1 - reduction, ply + 1, -alpha - 1,
+                                 -alpha, false);
+        if (score > alpha && reduction > 0) {
+          score = -negamax<k_them>(depth - 1, ply + 1, -alpha - 1, -alpha,
+                                   false);
+        }
+        if (score > alpha && score < beta) {
+          score = -negamax<k_them>(depth - 1, ply + 1, -beta, -alpha, true);
+        }
+      } else {
+        score = -negamax<k_them>(depth - 1 - reduction, ply + 1, -beta,
+                                 -alpha, is_pv);
+        if (score > alpha && reduction > 0) {
+          score = -negamax<k_them>(depth - 1, ply + 1, -beta, -alpha, is_pv);
+        }
+      }
+    }
+
+    board_.undo();
+    if (aborted_) {
+      return 0;
+    }
+
+    if (score > best_score) {
+      best_score = score;
+      best_move = move;
+      if (score > alpha) {
+        alpha = score;
+        if (alpha >= beta) {
+          stats_.fail_highs++;
+          if (i == 0) {
+            stats_.fail_highs_first++;
+          }
+          update_quiet_stats<Us>(move, depth, ply);
+          break;
+        }
+      }
+    }
+  }
+
+  Bound bound{Bound::Exact};
+  if (best_score <= alpha_orig) {
+    bound = Bound::Upper;
+  } else if (best_score >= beta) {
+    bound = Bound::Lower;
+  }
+  if (ply == 0) {
+    root_best_move_ = best_move;
+  }
+  // A root search with excluded moves says nothing about the root position
+  if (ply > 0 || excluded_root_moves_.empty()) {
+    tt_.store(hash, depth, score_to_tt(best_score, ply, k_win_bound), bound,
+              best_move);
+  }
+  return best_score;
+}
+
+/// <summary>
+/// Scores the position from the side to move's point of view: piece-square
+/// progress towards the opposite corner minus a penalty for the pawn that
+/// lags the furthest behind
+/// </summary>
+template <PieceColor Us>
+int AI::evaluate() const {
+  const int score{nnue_.is_loaded()
+                      ? nnue_.evaluate(board_.get_nnue_accumulator(), Us)
+                      : ::evaluate<Us>(board_)};
+  if (options_.eval_noise != 0) {
+    return score + get_eval_noise(board_.get_hash(), options_.eval_noise);
+  }
+  return score;
+}
+
+void AI::init_reductions() {
+  for (int depth = 1; depth < 64; depth++) {
+    for (int move = 1; move < 64; move++) {
+      reductions_[depth][move] = static_cast<int>(
+          options_.lmr_base + std::log(depth) * std::log(move) /
+                                  options_.lmr_divisor);
+    }
+  }
+}
+
+template <PieceColor Us>
+void AI::update_quiet_stats(Move move, int depth, int ply) {
+  auto& killers{killers_[ply]};
+  if (killers[0] != move) {
+    killers[1] = killers[0];
+    killers[0] = move;
+  }
+
+  int& history{history_[get_color_index(Us)][move.tile][move.target]};
+  history += depth * depth;
+  if (history > 1'000'000) {
+    for (auto& side : history_) {
+      for (auto& from : side) {
+        for (int& value : from) {
+          value /= 2;
+        }
+      }
+    }
+  }
+}
+
+template <PieceColor Us>
+void AI::order_moves(Moves& moves, Move tt_move, int ply) const {
+  const auto& history{history_[get_color_index(Us)]};
   const auto& begin{moves.data.begin()};
 
   std::sort(begin, begin + moves.size,
-            [this, &base_table](const Move& left, const Move& right) {
-              int left_value_before = base_table[left.tile];
-              int left_value_after = base_table[left.target];
-              int right_value_before = base_table[right.tile];
-              int right_value_after = base_table[right.target];
+            [&history](const Move& left, const Move& right) {
+              // Moves that caused cutoffs elsewhere in the tree go first
+              const int left_history{history[left.tile][left.target]};
+              const int right_history{history[right.tile][right.target]};
+              if (left_history != right_history) {
+                return left_history > right_history;
+              }
+
+              int left_value_before = get_pst_value<Us>(left.tile);
+              int left_value_after = get_pst_value<Us>(left.target);
+              int right_value_before = get_pst_value<Us>(right.tile);
+              int right_value_after = get_pst_value<Us>(right.target);
 
               // Check if moves decrease value
               bool left_decreases = left_value_after < left_value_before;
@@ -77,4 +670,17 @@ void AI::order_moves(Moves& moves) const {
               return (left_value_after - left_value_before) >
                      (right_value_after - right_value_before);
             });
+
+  // Hash move first, then the killers of this ply
+  int front{};
+  auto promote = [&moves, &front, begin](Move move) {
+    const auto end{begin + moves.size};
+    if (const auto it = std::find(begin + front, end, move); it != end) {
+      std::rotate(begin + front, it, it + 1);
+      front++;
+    }
+  };
+  promote(tt_move);
+  promote(killers_[ply][0]);
+  promote(killers_[ply][1]);
 }
@@ -0,0 +1,31 @@
+#include "alloc_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+#ifndef NDEBUG
+namespace {
+thread_local uint64_t thread_allocations{};
+}  // namespace
+
+uint64_t get_thread_allocations() { return thread_allocations; }
+
+// The array and nothrow forms of the standard library forward to this one.
+// Over-aligned allocations keep their own default functions and are not
+// counted
+void* operator new(size_t size) {
+  thread_allocations++;
+  if (void* pointer = std::malloc(size != 0 ? size : 1); pointer != nullptr) {
+    return pointer;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+
+void operator delete(void* pointer, size_t /*size*/) noexcept {
+  std::free(pointer);
+}
+#else
+uint64_t get_thread_allocations() { return 0; }
+#endif
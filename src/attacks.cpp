@@ -0,0 +1,189 @@
+#include "attacks.hpp"
+
+#include <bit>
+
+namespace {
+using Directions = std::array<std::array<int, 2>, 4>;
+
+constexpr Directions k_bishop_directions{{{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
+constexpr Directions k_rook_directions{{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+
+#ifndef __BMI2__
+// Magics a search with the seed below found. Trying them first keeps the
+// startup cost to filling the tables; the search only runs should one of
+// them stop fitting, e.g. after a change to the index function
+// clang-format off
+constexpr std::array<uint64_t, 64> k_bishop_magics{
+    0x0108600401860192ULL, 0x4008010144010000ULL, 0x01412107010000B0ULL,
+    0x1804106200040081ULL, 0x0004504010181018ULL, 0x0000825040040402ULL,
+    0x0002011160300400ULL, 0x0001004200E00804ULL, 0x0302080204644400ULL,
+    0x1012021004092444ULL, 0x2140884800608400ULL, 0x1820040408800108ULL,
+    0x0020020210001000ULL, 0x0082090420060800ULL, 0x0000012401044080ULL,
+    0x0010408404020320ULL, 0x40C0000888080080ULL, 0x0120000262040101ULL,
+    0x0132000108020080ULL, 0x0202002022004402ULL, 0x4018802400E00040ULL,
+    0x020301120084A400ULL, 0x0400B00404040240ULL, 0x1000900604410800ULL,
+    0x00A1905020023A04ULL, 0x1081080010025802ULL, 0x0221010010040028ULL,
+    0x0122002008008020ULL, 0xB023010041104000ULL, 0x48010040CA082000ULL,
+    0x0084042041010112ULL, 0x004C019020260108ULL, 0x0018201002098288ULL,
+    0x80A0841004041004ULL, 0x0000704C00080800ULL, 0x0002100820140400ULL,
+    0x6004010010240041ULL, 0x0800900100408080ULL, 0x301408009102149AULL,
+    0x0204004840509401ULL, 0x90009024A0001040ULL, 0x220C248218861001ULL,
+    0x1212002428004400ULL, 0x01830420110E0800ULL, 0x0000011020800401ULL,
+    0x0241011000844900ULL, 0x002001010104020DULL, 0x800421040020091AULL,
+    0x20004E1010080040ULL, 0x62410410C2081080ULL, 0x1006210888040810ULL,
+    0x4300008020882409ULL, 0x0000002004240614ULL, 0xD001202042008E00ULL,
+    0x02A0203109311080ULL, 0x8008104100630208ULL, 0x0502020111011000ULL,
+    0x0000060088B80810ULL, 0x0610000202010420ULL, 0x0084000102050429ULL,
+    0x020020002002CC04ULL, 0x0080100861084081ULL, 0x01C0202104212040ULL,
+    0xA002883001004100ULL};
+constexpr std::array<uint64_t, 64> k_rook_magics{
+    0x0080001082644001ULL, 0x0040001000402000ULL, 0x8100200041001008ULL,
+    0x0880100008018004ULL, 0x0E00082024500200ULL, 0x0100020400080100ULL,
+    0x0080020000800100ULL, 0x2080082100004080ULL, 0x0000800080400020ULL,
+    0x0000802000804010ULL, 0x0040802000100080ULL, 0x4028801000080080ULL,
+    0x0020800802040081ULL, 0x0082001004020008ULL, 0x2021000100A20004ULL,
+    0x0002000114208042ULL, 0x0000820021004200ULL, 0x8010024000402000ULL,
+    0x0206020028408010ULL, 0x4416808010000802ULL, 0x2002020004082110ULL,
+    0xA001010004000208ULL, 0x00044C00A8110A30ULL, 0x6021020000408104ULL,
+    0x0010800080284000ULL, 0x800BA00980400680ULL, 0x0004130500402000ULL,
+    0x14010089001000A0ULL, 0x0024080100110004ULL, 0x0024020080800400ULL,
+    0x0800120400180130ULL, 0x0021800080004100ULL, 0x0400401020800080ULL,
+    0x0000201000404000ULL, 0x3088200880801000ULL, 0x5402001042000820ULL,
+    0x1090800402800801ULL, 0x8204020080800400ULL, 0x0000C11204000810ULL,
+    0x030038C30E00208CULL, 0x0040400080048020ULL, 0x00A0100041614000ULL,
+    0x1010008020008010ULL, 0x0201002010010008ULL, 0xA0003200204A001AULL,
+    0x0105000804010002ULL, 0x0901000200A10014ULL, 0x0006042950820001ULL,
+    0x048000A0004000C0ULL, 0x0004810030420200ULL, 0x2000802000100080ULL,
+    0x0010080010048080ULL, 0x1890800400080280ULL, 0x1002008002040080ULL,
+    0x0808B04D18020400ULL, 0x18002710824C0200ULL, 0x4020230434800041ULL,
+    0x4A00201201004A82ULL, 0x0410104420010009ULL, 0x000300A018043001ULL,
+    0x088A000408203006ULL, 0x0003000400020801ULL, 0x0004021018013084ULL,
+    0x8180008040240902ULL};
+// clang-format on
+
+uint64_t next_random(uint64_t& state) {
+  uint64_t z{state += 0x9E3779B97F4A7C15ULL};
+  z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31U);
+}
+#endif
+
+constexpr bool is_on_board(int row, int column) {
+  return 0 <= row && row < 8 && 0 <= column && column < 8;
+}
+
+constexpr uint64_t get_bit(int row, int column) {
+  return uint64_t{1} << static_cast<unsigned>(row * 8 + column);
+}
+
+/// <summary>
+/// Reference attacks: every ray up to and including the first occupied tile
+/// </summary>
+uint64_t walk_rays(int tile, uint64_t occupied, const Directions& directions) {
+  uint64_t attacks{};
+  for (const auto& [rows, columns] : directions) {
+    for (int row = tile / 8 + rows, column = tile % 8 + columns;
+         is_on_board(row, column); row += rows, column += columns) {
+      attacks |= get_bit(row, column);
+      if ((occupied & get_bit(row, column)) != 0) {
+        break;
+      }
+    }
+  }
+  return attacks;
+}
+
+/// <summary>
+/// Ray tiles that can block, i.e. all but the last one of every ray
+/// </summary>
+uint64_t get_relevant_mask(int tile, const Directions& directions) {
+  uint64_t mask{};
+  for (const auto& [rows, columns] : directions) {
+    for (int row = tile / 8 + rows, column = tile % 8 + columns;
+         is_on_board(row + rows, column + columns);
+         row += rows, column += columns) {
+      mask |= get_bit(row, column);
+    }
+  }
+  return mask;
+}
+
+void fill_tables(std::array<SliderMagic, 64>& magics,
+                 const Directions& directions, std::vector<uint64_t>& attacks,
+                 [[maybe_unused]] const std::array<uint64_t, 64>& known_magics,
+                 [[maybe_unused]] uint64_t& state) {
+  std::vector<uint64_t> occupancies;
+  std::vector<uint64_t> references;
+  // Attempt that last wrote each slot, so a failed magic needs no clearing
+  [[maybe_unused]] std::vector<int> epochs;
+  for (int tile = 0; tile < 64; tile++) {
+    SliderMagic& magic{magics[tile]};
+    magic.mask = get_relevant_mask(tile, directions);
+    magic.shift = 64U - static_cast<unsigned>(std::popcount(magic.mask));
+    magic.offset = attacks.size();
+    const size_t size{size_t{1} << (64U - magic.shift)};
+    attacks.resize(magic.offset + size);
+
+    // Every subset of the mask, enumerated with the carry-rippler trick
+    occupancies.clear();
+    references.clear();
+    uint64_t subset{};
+    do {
+      occupancies.push_back(subset);
+      references.push_back(walk_rays(tile, subset, directions));
+      subset = (subset - magic.mask) & magic.mask;
+    } while (subset != 0);
+
+#ifdef __BMI2__
+    for (size_t i = 0; i < occupancies.size(); i++) {
+      attacks[magic.get_index(occupancies[i])] = references[i];
+    }
+#else
+    epochs.assign(size, 0);
+    for (int attempt = 1;; attempt++) {
+      if (attempt == 1) {
+        magic.magic = known_magics[tile];
+      } else {
+        // Sparse candidates that spread the mask into the top byte work best
+        do {
+          magic.magic =
+              next_random(state) & next_random(state) & next_random(state);
+        } while (std::popcount((magic.mask * magic.magic) >> 56U) < 6);
+      }
+
+      bool is_valid{true};
+      for (size_t i = 0; i < occupancies.size() && is_valid; i++) {
+        const size_t index{magic.get_index(occupancies[i])};
+        int& epoch{epochs[index - magic.offset]};
+        if (epoch != attempt) {
+          epoch = attempt;
+          attacks[index] = references[i];
+        } else if (attacks[index] != references[i]) {
+          // Two occupancies with different attacks collide
+          is_valid = false;
+        }
+      }
+      if (is_valid) {
+        break;
+      }
+    }
+#endif
+  }
+}
+}  // namespace
+
+SliderTables make_slider_tables() {
+  SliderTables tables;
+#ifdef __BMI2__
+  // PEXT needs no magics
+  constexpr std::array<uint64_t, 64> k_bishop_magics{};
+  constexpr std::array<uint64_t, 64> k_rook_magics{};
+#endif
+  uint64_t state{0x4D61676963734350ULL};
+  fill_tables(tables.bishops, k_bishop_directions, tables.attacks,
+              k_bishop_magics, state);
+  fill_tables(tables.rooks, k_rook_directions, tables.attacks, k_rook_magics,
+              state);
+  return tables;
+}
@@ -0,0 +1,201 @@
+#include "batch_eval.hpp"
+
+#include "evaluation.hpp"
+#include "simd.hpp"
+
+#ifdef CORNERPAWNS_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+using Table = std::array<int32_t, 65>;
+
+template <typename Function>
+constexpr Table make_table(Function function) {
+  Table table{};
+  for (int tile = 0; tile < 64; tile++) {
+    table[static_cast<size_t>(tile)] = function(tile);
+  }
+  return table;
+}
+
+// Gather sources, one entry per tile plus the zero entry for k_no_pawn
+alignas(64) constexpr Table k_white_pst{make_table(
+    [](int tile) { return get_pst_value(PieceColor::White, tile); })};
+alignas(64) constexpr Table k_black_pst{make_table(
+    [](int tile) { return get_pst_value(PieceColor::Black, tile); })};
+alignas(64) constexpr Table k_white_distance{make_table(
+    [](int tile) { return get_straggler_distance(PieceColor::White, tile); })};
+alignas(64) constexpr Table k_black_distance{make_table(
+    [](int tile) { return get_straggler_distance(PieceColor::Black, tile); })};
+
+void evaluate_scalar(const PositionBatch& batch, std::span<int32_t> scores,
+                     size_t begin) {
+  const auto& white_tiles{batch.get_white_tiles()};
+  const auto& black_tiles{batch.get_black_tiles()};
+  for (size_t i = begin; i < batch.get_size(); i++) {
+    int32_t white_score{};
+    int32_t black_score{};
+    int32_t white_straggler{};
+    int32_t black_straggler{};
+    for (size_t slot = 0; slot < PositionBatch::k_max_pawns; slot++) {
+      const auto white_tile{static_cast<size_t>(white_tiles[slot][i])};
+      const auto black_tile{static_cast<size_t>(black_tiles[slot][i])};
+      white_score += k_white_pst[white_tile];
+      black_score += k_black_pst[black_tile];
+      white_straggler =
+          std::max(white_straggler, k_white_distance[white_tile]);
+      black_straggler =
+          std::max(black_straggler, k_black_distance[black_tile]);
+    }
+    const int32_t score{
+        (white_score - black_score) -
+        k_straggler_weight * (white_straggler - black_straggler)};
+    scores[i] = score * batch.get_signs()[i];
+  }
+}
+
+#ifdef CORNERPAWNS_X86
+CORNERPAWNS_TARGET("avx2")
+size_t evaluate_avx2(const PositionBatch& batch, std::span<int32_t> scores) {
+  const auto& white_tiles{batch.get_white_tiles()};
+  const auto& black_tiles{batch.get_black_tiles()};
+  const __m256i straggler_weight{_mm256_set1_epi32(k_straggler_weight)};
+  size_t i{};
+  for (; i + 8 <= batch.get_size(); i += 8) {
+    __m256i white_score{_mm256_setzero_si256()};
+    __m256i black_score{_mm256_setzero_si256()};
+    __m256i white_straggler{_mm256_setzero_si256()};
+    __m256i black_straggler{_mm256_setzero_si256()};
+    for (size_t slot = 0; slot < PositionBatch::k_max_pawns; slot++) {
+      const __m256i white_tile{_mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(&white_tiles[slot][i]))};
+      const __m256i black_tile{_mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(&black_tiles[slot][i]))};
+      white_score = _mm256_add_epi32(
+          white_score,
+          _mm256_i32gather_epi32(k_white_pst.data(), white_tile, 4));
+      black_score = _mm256_add_epi32(
+          black_score,
+          _mm256_i32gather_epi32(k_black_pst.data(), black_tile, 4));
+      white_straggler = _mm256_max_epi32(
+          white_straggler,
+          _mm256_i32gather_epi32(k_white_distance.data(), white_tile, 4));
+      black_straggler = _mm256_max_epi32(
+          black_straggler,
+          _mm256_i32gather_epi32(k_black_distance.data(), black_tile, 4));
+    }
+    const __m256i penalty{_mm256_mullo_epi32(
+        straggler_weight, _mm256_sub_epi32(white_straggler, black_straggler))};
+    const __m256i score{_mm256_sub_epi32(
+        _mm256_sub_epi32(white_score, black_score), penalty)};
+    const __m256i signs{_mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(&batch.get_signs()[i]))};
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&scores[i]),
+                        _mm256_mullo_epi32(score, signs));
+  }
+  return i;
+}
+
+CORNERPAWNS_TARGET("avx512f")
+size_t evaluate_avx512(const PositionBatch& batch, std::span<int32_t> scores) {
+  const auto& white_tiles{batch.get_white_tiles()};
+  const auto& black_tiles{batch.get_black_tiles()};
+  const __m512i straggler_weight{_mm512_set1_epi32(k_straggler_weight)};
+  size_t i{};
+  for (; i + 16 <= batch.get_size(); i += 16) {
+    __m512i white_score{_mm512_setzero_si512()};
+    __m512i black_score{_mm512_setzero_si512()};
+    __m512i white_straggler{_mm512_setzero_si512()};
+    __m512i black_straggler{_mm512_setzero_si512()};
+    for (size_t slot = 0; slot < PositionBatch::k_max_pawns; slot++) {
+      const __m512i white_tile{_mm512_loadu_si512(&white_tiles[slot][i])};
+      const __m512i black_tile{_mm512_loadu_si512(&black_tiles[slot][i])};
+      white_score = _mm512_add_epi32(
+          white_score,
+          _mm512_i32gather_epi32(white_tile, k_white_pst.data(), 4));
+      black_score = _mm512_add_epi32(
+          black_score,
+          _mm512_i32gather_epi32(black_tile, k_black_pst.data(), 4));
+      white_straggler = _mm512_max_epi32(
+          white_straggler,
+          _mm512_i32gather_epi32(white_tile, k_white_distance.data(), 4));
+      black_straggler = _mm512_max_epi32(
+          black_straggler,
+          _mm512_i32gather_epi32(black_tile, k_black_distance.data(), 4));
+    }
+    const __m512i penalty{_mm512_mullo_epi32(
+        straggler_weight, _mm512_sub_epi32(white_straggler, black_straggler))};
+    const __m512i score{_mm512_sub_epi32(
+        _mm512_sub_epi32(white_score, black_score), penalty)};
+    const __m512i signs{_mm512_loadu_si512(&batch.get_signs()[i])};
+    _mm512_storeu_si512(&scores[i], _mm512_mullo_epi32(score, signs));
+  }
+  return i;
+}
+
+#endif
+}  // namespace
+
+void PositionBatch::clear() {
+  for (size_t slot = 0; slot < k_max_pawns; slot++) {
+    white_tiles_[slot].clear();
+    black_tiles_[slot].clear();
+  }
+  signs_.clear();
+}
+
+void PositionBatch::reserve(size_t size) {
+  for (size_t slot = 0; slot < k_max_pawns; slot++) {
+    white_tiles_[slot].reserve(size);
+    black_tiles_[slot].reserve(size);
+  }
+  signs_.reserve(size);
+}
+
+bool PositionBatch::add(const Board& board) {
+  std::array<int32_t, k_max_pawns> white{};
+  std::array<int32_t, k_max_pawns> black{};
+  white.fill(k_no_pawn);
+  black.fill(k_no_pawn);
+  size_t white_count{};
+  size_t black_count{};
+  for (int tile = 0; tile < 64; tile++) {
+    const PieceColor color{board.get_color(tile)};
+    if (color == PieceColor::None) {
+      continue;
+    }
+    size_t& count{color == PieceColor::White ? white_count : black_count};
+    auto& tiles{color == PieceColor::White ? white : black};
+    if (count == k_max_pawns) {
+      return false;
+    }
+    tiles[count++] = tile;
+  }
+
+  for (size_t slot = 0; slot < k_max_pawns; slot++) {
+    white_tiles_[slot].push_back(white[slot]);
+    black_tiles_[slot].push_back(black[slot]);
+  }
+  signs_.push_back(board.get_turn() == PieceColor::White ? 1 : -1);
+  return true;
+}
+
+void evaluate_batch(const PositionBatch& batch, std::span<int32_t> scores,
+                    SimdLevel level) {
+  assert(scores.size() >= batch.get_size());
+  size_t done{};
+#ifdef CORNERPAWNS_X86
+  // Never run instructions the CPU lacks, whatever the caller asked for
+  level = std::min(level, get_simd_level());
+  if (level == SimdLevel::Avx512) {
+    done = evaluate_avx512(batch, scores);
+  } else if (level == SimdLevel::Avx2) {
+    done = evaluate_avx2(batch, scores);
+  }
+#else
+  (void)level;
+#endif
+  // The tail that doesn't fill a whole vector
+  evaluate_scalar(batch, scores, done);
+}
@@ -0,0 +1,268 @@
+#include "bench.hpp"
+
+#include <format>
+#include <random>
+
+#include "batch_eval.hpp"
+#include "evaluation.hpp"
+#include "nnue.hpp"
+
+namespace {
+constexpr std::array k_bench_fens{
+    std::string_view{"ppp5/ppp5/ppp5/8/8/5PPP/5PPP/5PPP w KQkq - 0 1"},
+    std::string_view{"ppp5/pp1p4/p1p5/1p6/3P4/2P2PP1/4PPP1/5P1P b - - 0 1"},
+    std::string_view{"8/1pp5/pp1p4/1pp1P3/p1PpP3/3P1P2/4PP2/6PP w - - 0 1"},
+    std::string_view{"PP6/P1P5/PP6/2p1P3/1P1p4/3pp3/3P2pp/5ppp b - - 0 1"},
+};
+
+struct BenchConfig {
+  std::string_view name;
+  bool use_pvs;
+  bool use_aspiration;
+  bool use_lmr;
+};
+
+constexpr int k_bench_multi_pv{4};
+
+constexpr size_t k_eval_bench_positions{1 << 14};
+constexpr int k_eval_bench_rounds{200};
+constexpr int k_nnue_bench_moves{1 << 20};
+constexpr size_t k_fen_bench_positions{1 << 12};
+constexpr int k_fen_bench_rounds{256};
+
+constexpr std::array k_bench_configs{
+    BenchConfig{"alpha-beta", false, false, false},
+    BenchConfig{"+pvs", true, false, false},
+    BenchConfig{"+aspiration", false, true, false},
+    BenchConfig{"+lmr", false, false, true},
+    BenchConfig{"all", true, true, true},
+};
+/// <summary>
+/// Times evaluate_batch() at every supported SIMD level on positions reached
+/// by random moves from the bench positions, checking each result against
+/// evaluate()
+/// </summary>
+void run_eval_bench(std::ostream& out) {
+  PositionBatch batch;
+  batch.reserve(k_eval_bench_positions);
+  std::vector<int32_t> expected;
+  std::mt19937 generator{2024};
+  Board board;
+  while (batch.get_size() < k_eval_bench_positions) {
+    board.load_fen(k_bench_fens[batch.get_size() % k_bench_fens.size()]);
+    for (int ply = 0; ply < 40; ply++) {
+      Moves moves;
+      board.generate_all_legal_moves(moves);
+      if (moves.size == 0) {
+        break;
+      }
+      board.move(moves.data[std::uniform_int_distribution<int>{
+          0, moves.size - 1}(generator)]);
+      batch.add(board);
+      expected.push_back(evaluate(board));
+    }
+  }
+
+  std::vector<int32_t> scores(batch.get_size());
+  double scalar_rate{};
+  for (const SimdLevel level :
+       {SimdLevel::Scalar, SimdLevel::Avx2, SimdLevel::Avx512}) {
+    if (level > get_simd_level()) {
+      break;
+    }
+    const auto start{std::chrono::steady_clock::now()};
+    for (int round = 0; round < k_eval_bench_rounds; round++) {
+      evaluate_batch(batch, scores, level);
+    }
+    const std::chrono::duration<double> elapsed{
+        std::chrono::steady_clock::now() - start};
+    const double rate{static_cast<double>(batch.get_size()) *
+                      k_eval_bench_rounds / elapsed.count() / 1e6};
+    if (level == SimdLevel::Scalar) {
+      scalar_rate = rate;
+    }
+    out << std::format("batch eval {:<7} {:>8.1f} M positions/s ({:.2f}x) {}\n",
+                       to_string(level), rate, rate / scalar_rate,
+                       scores == expected ? "ok" : "MISMATCH");
+  }
+}
+
+/// <summary>
+/// Times move(), evaluation and undo() with the PST evaluation and with a
+/// random network attached, checking the incremental accumulator against a
+/// full refresh
+/// </summary>
+void run_nnue_bench(std::ostream& out) {
+  Nnue nnue;
+  nnue.init_random(2024);
+
+  for (const bool use_nnue : {false, true}) {
+    std::mt19937 generator{2024};
+    Board board;
+    board.set_nnue(use_nnue ? &nnue : nullptr);
+    board.load_fen(k_bench_fens[0]);
+    NnueAccumulator refreshed;
+    bool is_matching{true};
+    int64_t checksum{};
+    uint64_t positions{};
+
+    const auto start{std::chrono::steady_clock::now()};
+    for (int i = 0; i < k_nnue_bench_moves; i++) {
+      Moves moves;
+      board.generate_all_legal_moves(moves);
+      if (moves.size == 0) {
+        board.load_fen(k_bench_fens[0]);
+        continue;
+      }
+      // Every move is searched and taken back, as in the search, before
+      // the walk continues with one of them
+      for (int j = 0; j < moves.size; j++) {
+        board.move(moves.data[j]);
+        checksum += use_nnue ? nnue.evaluate(board.get_nnue_accumulator(),
+                                             board.get_turn())
+                             : evaluate(board);
+        positions++;
+        board.undo();
+      }
+      board.move(moves.data[std::uniform_int_distribution<int>{
+          0, moves.size - 1}(generator)]);
+      if (use_nnue && i % 1024 == 0) {
+        nnue.refresh(board, refreshed);
+        is_matching = is_matching && refreshed.values ==
+                                         board.get_nnue_accumulator().values;
+      }
+    }
+    const std::chrono::duration<double> elapsed{
+        std::chrono::steady_clock::now() - start};
+    out << std::format(
+        "{} move+eval+undo {:>8.1f} M positions/s checksum {} {}\n",
+        use_nnue ? "nnue" : "pst ",
+        static_cast<double>(positions) / elapsed.count() / 1e6, checksum,
+        is_matching ? "ok" : "MISMATCH");
+  }
+}
+
+/// <summary>
+/// Times load_fen() followed by to_fen() on positions reached by random
+/// moves, checking that text and hash come back unchanged
+/// </summary>
+void run_fen_bench(std::ostream& out) {
+  std::vector<std::string> fens;
+  std::vector<uint64_t> hashes;
+  std::mt19937 generator{2024};
+  Board board;
+  while (fens.size() < k_fen_bench_positions) {
+    board.load_fen(k_bench_fens[fens.size() % k_bench_fens.size()]);
+    for (int ply = 0; ply < 40; ply++) {
+      Moves moves;
+      board.generate_all_legal_moves(moves);
+      if (moves.size == 0) {
+        break;
+      }
+      board.move(moves.data[std::uniform_int_distribution<int>{
+          0, moves.size - 1}(generator)]);
+      fens.push_back(board.to_fen());
+      hashes.push_back(board.get_hash());
+    }
+  }
+
+  bool is_matching{true};
+  const auto start{std::chrono::steady_clock::now()};
+  for (int round = 0; round < k_fen_bench_rounds; round++) {
+    for (size_t i = 0; i < fens.size(); i++) {
+      is_matching = board.load_fen(fens[i]) && is_matching;
+      is_matching = board.get_hash() == hashes[i] && is_matching;
+      is_matching = board.to_fen() == fens[i] && is_matching;
+    }
+  }
+  const std::chrono::duration<double> elapsed{
+      std::chrono::steady_clock::now() - start};
+  out << std::format(
+      "fen parse+write {:>8.1f} M positions/s {}\n",
+      static_cast<double>(fens.size()) * k_fen_bench_rounds /
+          elapsed.count() / 1e6,
+      is_matching ? "ok" : "MISMATCH");
+}
+
+/// <summary>
+/// Compares the nodes of a multi-PV search with a single-PV one. Later lines
+/// find most of their subtrees in the hash the first line filled
+/// </summary>
+void run_multi_pv_bench(std::ostream& out, int depth) {
+  std::array<uint64_t, 2> nodes{};
+  std::array<double, 2> ms{};
+  for (size_t i = 0; i < nodes.size(); i++) {
+    SearchOptions options;
+    options.max_depth = depth;
+    SearchLimits limits;
+    limits.multi_pv = i == 0 ? 1 : k_bench_multi_pv;
+    for (const std::string_view fen : k_bench_fens) {
+      AI ai{options};
+      Board board;
+      board.load_fen(fen);
+      const SearchResult result{ai.find_best_move(board, limits)};
+      nodes[i] += result.stats.nodes;
+      ms[i] += result.stats.elapsed_ms;
+    }
+  }
+  out << std::format(
+      "multipv {} depth {} nodes {:>10} ({:.2f}x) time {:>8.1f} ms "
+      "({:.2f}x)\n\n",
+      k_bench_multi_pv, depth, nodes[1],
+      static_cast<double>(nodes[1]) / static_cast<double>(nodes[0]), ms[1],
+      ms[1] / ms[0]);
+}
+}  // namespace
+
+void run_bench(std::ostream& out, int depth) {
+  uint64_t base_nodes{};
+  double base_ms{};
+
+  for (const BenchConfig& config : k_bench_configs) {
+    SearchOptions options;
+    options.max_depth = depth;
+    options.use_pvs = config.use_pvs;
+    options.use_aspiration = config.use_aspiration;
+    options.use_lmr = config.use_lmr;
+
+    uint64_t nodes{};
+    double ms{};
+    for (const std::string_view fen : k_bench_fens) {
+      // A fresh engine per position so no hash or history carries over
+      AI ai{options};
+      Board board;
+      board.load_fen(fen);
+
+      const auto start{std::chrono::steady_clock::now()};
+      const SearchResult result{ai.find_best_move(board)};
+      const std::chrono::duration<double, std::milli> elapsed{
+          std::chrono::steady_clock::now() - start};
+
+      nodes += result.stats.nodes;
+      ms += elapsed.count();
+      out << std::format(
+          "{:<12} {:>2} -> {:<2} score {:>6} nodes {:>10}\n", config.name,
+          result.best_move.tile, result.best_move.target, result.score,
+          result.stats.nodes);
+    }
+
+    if (base_nodes == 0) {
+      base_nodes = nodes;
+      base_ms = ms;
+    }
+    const double node_delta{100.0 * (static_cast<double>(nodes) /
+                                         static_cast<double>(base_nodes) -
+                                     1.0)};
+    const double time_delta{100.0 * (ms / base_ms - 1.0)};
+    out << std::format(
+        "{:<12} depth {} nodes {:>10} ({:+.1f}%) time {:>8.1f} ms ({:+.1f}%) "
+        "nps {:.0f}\n\n",
+        config.name, depth, nodes, node_delta, ms, time_delta,
+        static_cast<double>(nodes) * 1000.0 / ms);
+  }
+
+  run_multi_pv_bench(out, depth);
+  run_eval_bench(out);
+  run_nnue_bench(out);
+  run_fen_bench(out);
+}
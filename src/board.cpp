@@ -1,34 +1,77 @@
 #include "board.hpp"
 
-Board::Board() { load_fen(); }
-
-void Board::make_move(Move move) {
-  this->move(move);
-  const bool has_legal_moves{this->has_legal_moves()};
-  is_in_checkmate_ = !has_legal_moves;
+#include <algorithm>
 
-  int whiteScore = 0;
-  int blackScore = 0;
+#include "attacks.hpp"
 
-  {
-    std::lock_guard<std::mutex> lock(score_mutex_);  // Lock the mutex
+namespace {
+constexpr uint64_t splitmix64(uint64_t& state) {
+  uint64_t z{state += 0x9E3779B97F4A7C15ULL};
+  z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31U);
+}
 
-    for (int i = 0; i < 9; i++) {
-      if (get_color(blackBase[i].tile) == PieceColor::White) {
-        whiteScore++;
-      }
-      if (get_color(whiteBase[i].tile) == PieceColor::Black) {
-        blackScore++;
-      }
+struct ZobristKeys {
+  // Indexed by the raw Piece value, so new piece types need no extra tables
+  std::array<std::array<uint64_t, 64>, 32> pieces{};
+  uint64_t black_to_move{};
+};
+
+constexpr ZobristKeys make_zobrist_keys() {
+  ZobristKeys keys;
+  uint64_t state{0x436F726E65725061ULL};
+  for (auto& piece_keys : keys.pieces) {
+    for (auto& key : piece_keys) {
+      key = splitmix64(state);
     }
+  }
+  keys.black_to_move = splitmix64(state);
+  return keys;
+}
 
-    std::cout << "SCORES: White: " << whiteScore << " Black: " << blackScore
-              << "\n";
+constexpr ZobristKeys k_zobrist{make_zobrist_keys()};
 
-    if (whiteScore == 9 || blackScore == 9) {
-      is_in_checkmate_ = true;
-    }
-  }  // Mutex unlocks here
+constexpr uint64_t get_piece_key(Piece piece, int tile) {
+  return k_zobrist.pieces[to_underlying(piece)][tile];
+}
+
+// FEN letters indexed by the PieceType value, lower case being black
+constexpr std::string_view k_fen_letters{" pnbrqk"};
+
+constexpr std::array<Piece, 128> make_fen_pieces() {
+  std::array<Piece, 128> pieces{};
+  for (size_t i = 1; i < k_fen_letters.size(); i++) {
+    const auto type{static_cast<PieceType>(i)};
+    const auto letter{static_cast<size_t>(k_fen_letters[i])};
+    pieces[letter] = make_piece(PieceColor::Black, type);
+    pieces[letter - 'a' + 'A'] = make_piece(PieceColor::White, type);
+  }
+  return pieces;
+}
+
+// Indexed by the character, empty for anything but a piece letter
+constexpr std::array<Piece, 128> k_fen_pieces{make_fen_pieces()};
+
+// Eight full ranks with their separators and the fixed trailing fields
+constexpr size_t k_max_fen_size{64 + 7 + 10};
+
+constexpr char get_fen_letter(Piece piece) {
+  const char letter{k_fen_letters[to_underlying(get_piece_type(piece))]};
+  return get_piece_color(piece) == PieceColor::White
+             ? static_cast<char>(letter - 'a' + 'A')
+             : letter;
+}
+}  // namespace
+
+Board::Board() { load_fen(); }
+
+void Board::make_move(Move move) {
+  this->move(move);
+  is_in_checkmate_ = is_target_filled<PieceColor::White>() ||
+                     is_target_filled<PieceColor::Black>() ||
+                     !has_legal_moves();
+  is_draw_ = !is_in_checkmate_ && is_repetition_draw();
 }
 
 void Board::undo() {
@@ -45,12 +88,32 @@ void Board::undo() {
   set_tile(captured_tile, record.captured_piece);
 
   turn_ = get_opposite_color(turn_);
+  hash_ = hash_history_.back();
+  hash_history_.pop_back();
+  if (nnue_ != nullptr) {
+    nnue_->move_piece(accumulator_, get_tile(record.move.tile),
+                      record.move.target, record.move.tile);
+    if (record.captured_piece != Piece{}) {
+      nnue_->add_piece(accumulator_, record.captured_piece,
+                       record.move.target);
+    }
+  }
   is_in_checkmate_ = record.is_in_checkmate_;
+  is_draw_ = record.is_draw_;
+  reversible_plies_ = record.reversible_plies_;
 
   records_.pop_back();
 }
 
 void Board::generate_all_legal_moves(Moves& moves, bool only_captures) {
+  if (!only_captures) {
+    if (turn_ == PieceColor::White) {
+      generate_all_moves<PieceColor::White>(moves);
+    } else if (turn_ == PieceColor::Black) {
+      generate_all_moves<PieceColor::Black>(moves);
+    }
+    return;
+  }
   for (int tile = 0; tile < 64; tile++) {
     generate_legal_moves(moves, tile, only_captures);
   }
@@ -78,6 +141,10 @@ uint64_t Board::perft(int depth) {
   if (depth == 0) {
     return 1;
   }
+  // The last ply is counted in bulk
+  if (depth == 1) {
+    return static_cast<uint64_t>(count_legal_moves());
+  }
 
   Moves moves;
   generate_all_legal_moves(moves);
@@ -90,81 +157,135 @@ uint64_t Board::perft(int depth) {
   return nodes;
 }
 
-void Board::load_fen(std::string_view fen) {
-  blackBase.clear();
-  blackBase.push_back(CornerTile(56, false));
-  blackBase.push_back(CornerTile(48, false));
-  blackBase.push_back(CornerTile(49, false));
-  blackBase.push_back(CornerTile(57, false));
-  blackBase.push_back(CornerTile(40, false));
-  blackBase.push_back(CornerTile(41, false));
-  blackBase.push_back(CornerTile(42, false));
-  blackBase.push_back(CornerTile(50, false));
-  blackBase.push_back(CornerTile(58, false));
-
-  whiteBase.clear();
-  whiteBase.push_back(CornerTile(7, false));
-  whiteBase.push_back(CornerTile(6, false));
-  whiteBase.push_back(CornerTile(14, false));
-  whiteBase.push_back(CornerTile(15, false));
-  whiteBase.push_back(CornerTile(5, false));
-  whiteBase.push_back(CornerTile(13, false));
-  whiteBase.push_back(CornerTile(21, false));
-  whiteBase.push_back(CornerTile(22, false));
-  whiteBase.push_back(CornerTile(23, false));
-
-  turn_ = {};
-  tiles_ = {};
-  is_in_checkmate_ = false;
-  records_ = {};
+std::string move_to_string(Move move) {
+  auto tile_to_string = [](int tile) {
+    return std::string{static_cast<char>('a' + get_tile_column(tile)),
+                       static_cast<char>('1' + get_tile_row(tile))};
+  };
+  return tile_to_string(move.tile) + tile_to_string(move.target);
+}
 
-  std::array<std::string_view, 6> parts{};
-  for (int i = 0, begin = 0, end = 0; i < 6; i++) {
-    begin = end;
-    end = static_cast<int>(fen.find_first_of(' ', begin + 1));
-    parts[i] = fen.substr(begin, end - begin);
-    end++;  // Skip whitespace
+std::optional<Move> parse_move(std::string_view text) {
+  if (text.size() != 4) {
+    return std::nullopt;
+  }
+  auto parse_tile = [](char file, char rank) {
+    if (file < 'a' || file > 'h' || rank < '1' || rank > '8') {
+      return -1;
+    }
+    return (rank - '1') * 8 + (file - 'a');
+  };
+  const Move move{parse_tile(text[0], text[1]), parse_tile(text[2], text[3])};
+  if (move.tile == -1 || move.target == -1) {
+    return std::nullopt;
   }
+  return move;
+}
 
-  for (int i = 0, tile = 0; i < parts[0].length(); i++) {
-    const char ch{parts[0][i]};
+int Board::count_in_target(PieceColor color) const {
+  return color == PieceColor::White ? count_in_target<PieceColor::White>()
+                                    : count_in_target<PieceColor::Black>();
+}
 
+bool Board::load_fen(std::string_view fen) {
+  std::array<Piece, 64> tiles{};
+  std::array<uint64_t, 2> occupancy{};
+  std::array<uint64_t, 8> type_occupancy{};
+  uint64_t hash{};
+
+  // Ranks run from 8 down to 1, so the placement fills rows top down
+  int row{7};
+  int column{};
+  size_t index{};
+  for (; index < fen.size() && fen[index] != ' '; index++) {
+    const char ch{fen[index]};
     if (ch == '/') {
-      continue;
-    }
-
-    if (ch >= '0' && ch <= '8') {
-      tile += ch - '0';
-      continue;
+      if (column != 8 || row == 0) {
+        return false;
+      }
+      row--;
+      column = 0;
+    } else if ('1' <= ch && ch <= '8') {
+      column += ch - '0';
+      if (column > 8) {
+        return false;
+      }
+    } else {
+      const Piece piece{k_fen_pieces[static_cast<unsigned char>(ch)]};
+      if (piece == Piece{} || column == 8) {
+        return false;
+      }
+      const int tile{row * 8 + column++};
+      const uint64_t bit{uint64_t{1} << static_cast<unsigned>(tile)};
+      tiles[tile] = piece;
+      occupancy[get_color_index(get_piece_color(piece))] |= bit;
+      type_occupancy[to_underlying(get_piece_type(piece))] |= bit;
+      hash ^= get_piece_key(piece, tile);
     }
+  }
+  if (row != 0 || column != 8 ||
+      std::popcount(occupancy[0]) > k_max_pieces_per_side ||
+      std::popcount(occupancy[1]) > k_max_pieces_per_side) {
+    return false;
+  }
 
-    auto color{PieceColor::Black};
-    if (ch >= 'A' && ch < 'Z') {
-      color = PieceColor::White;
-    }
+  // Castling, en passant and the move counters mean nothing here and are
+  // ignored when present
+  const std::string_view side{fen.substr(std::min(index + 1, fen.size()),
+                                         1)};
+  if ((side != "w" && side != "b") ||
+      (index + 2 < fen.size() && fen[index + 2] != ' ')) {
+    return false;
+  }
 
-    const int tile_rot{8 * (7 - get_tile_row(tile)) + get_tile_column(tile)};
+  turn_ = side == "w" ? PieceColor::White : PieceColor::Black;
+  tiles_ = tiles;
+  occupancy_ = occupancy;
+  type_occupancy_ = type_occupancy;
+  hash_ = turn_ == PieceColor::Black ? hash ^ k_zobrist.black_to_move : hash;
+  is_in_checkmate_ = false;
+  is_draw_ = false;
+  records_.clear();
+  hash_history_.clear();
+  reversible_plies_ = 0;
+  if (nnue_ != nullptr) {
+    nnue_->refresh(*this, accumulator_);
+  }
+  return true;
+}
 
-    PieceType type{};
-    switch (ch) {
-      case 'P':
-      case 'p':
-        type = PieceType::Pawn;
-        break;
-      default:
-        break;
+std::string Board::to_fen() const {
+  std::string fen;
+  fen.reserve(k_max_fen_size);
+  for (int row = 7; row >= 0; row--) {
+    char empty{'0'};
+    for (int column = 0; column < 8; column++) {
+      const Piece piece{tiles_[row * 8 + column]};
+      if (piece == Piece{}) {
+        empty++;
+        continue;
+      }
+      if (empty != '0') {
+        fen += empty;
+        empty = '0';
+      }
+      fen += get_fen_letter(piece);
     }
-
-    if (type != PieceType::None) {
-      set_tile(tile_rot, make_piece(color, type));
+    if (empty != '0') {
+      fen += empty;
+    }
+    if (row != 0) {
+      fen += '/';
     }
-    tile++;
   }
+  fen += turn_ == PieceColor::White ? " w - - 0 1" : " b - - 0 1";
+  return fen;
+}
 
-  if (parts[1] == "w") {
-    turn_ = PieceColor::White;
-  } else if (parts[1] == "b") {
-    turn_ = PieceColor::Black;
+void Board::set_nnue(const Nnue* nnue) {
+  nnue_ = nnue;
+  if (nnue_ != nullptr) {
+    nnue_->refresh(*this, accumulator_);
   }
 }
 
@@ -173,49 +294,187 @@ void Board::move(Move move) {
          get_type(move.tile) != PieceType::None);
 
   const MoveRecord& record{records_.emplace_back(
-      move, get_tile(move.target), is_in_checkmate_)};
-  set_tile(move.target, get_tile(move.tile));
+      move, get_tile(move.target), is_in_checkmate_, is_draw_,
+      reversible_plies_)};
+  const Piece piece{get_tile(move.tile)};
+  hash_history_.push_back(hash_);
+  hash_ = get_hash_after(move);
+  reversible_plies_ =
+      record.captured_piece != Piece{} ? 0 : reversible_plies_ + 1;
+  set_tile(move.target, piece);
   set_tile(move.tile, {});
+  if (nnue_ != nullptr) {
+    if (record.captured_piece != Piece{}) {
+      nnue_->remove_piece(accumulator_, record.captured_piece, move.target);
+    }
+    nnue_->move_piece(accumulator_, piece, move.tile, move.target);
+  }
 
   turn_ = get_opposite_color(turn_);
 }
 
-bool Board::has_legal_moves() {
-  Moves moves;
-  for (int tile = 0; tile < 64; tile++) {
-    generate_legal_moves(moves, tile);
-    if (moves.size != 0) {
+uint64_t Board::get_hash_after(Move move) const {
+  const Piece piece{get_tile(move.tile)};
+  uint64_t hash{hash_ ^ get_piece_key(piece, move.tile) ^
+                get_piece_key(piece, move.target) ^ k_zobrist.black_to_move};
+  if (const Piece captured{get_tile(move.target)}; captured != Piece{}) {
+    hash ^= get_piece_key(captured, move.target);
+  }
+  return hash;
+}
+
+bool Board::is_repetition_draw(int search_plies) const {
+  if (repetition_limit_ == 0) {
+    return false;
+  }
+  const int size{static_cast<int>(hash_history_.size())};
+  const int oldest{size - reversible_plies_};
+  int count{1};
+  // Only positions with the same side to move can be equal
+  for (int ply = size - 2; ply >= oldest; ply -= 2) {
+    if (hash_history_[ply] == hash_ &&
+        (size - ply <= search_plies || ++count >= repetition_limit_)) {
       return true;
     }
   }
   return false;
 }
 
-void Board::generate_moves(Moves& moves, int tile) const {
-  const int row{get_tile_row(tile)};
-  const int col{get_tile_column(tile)};
+bool Board::has_legal_moves() const {
+  switch (turn_) {
+    case PieceColor::White:
+      return has_legal_moves<PieceColor::White>();
+    case PieceColor::Black:
+      return has_legal_moves<PieceColor::Black>();
+    default:
+      return false;
+  }
+}
 
-  const PieceType tile_type{get_type(tile)};
+bool Board::has_other_moves() const {
+  if (turn_ == PieceColor::None) {
+    return false;
+  }
+  const uint64_t pieces{get_occupancy(turn_)};
+  const uint64_t pawns{pieces & get_pieces(PieceType::Pawn)};
+  if (jumps_) {
+    for (uint64_t set{pawns}; set != 0; set &= set - 1) {
+      if (get_jump_targets(std::countr_zero(set)) != 0) {
+        return true;
+      }
+    }
+  }
+  for (uint64_t set{pieces & ~pawns}; set != 0; set &= set - 1) {
+    if (get_piece_targets(std::countr_zero(set)) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
 
-#define CHECK_MOVE_OFFSET(offset, condition)           \
-  if (const int target = tile + (offset); condition) { \
-    add_move(moves, tile, target);                     \
+int Board::count_legal_moves() const {
+  int count{get_step_targets(turn_).count()};
+  if (turn_ == PieceColor::None) {
+    return count;
+  }
+  const uint64_t pieces{get_occupancy(turn_)};
+  const uint64_t pawns{pieces & get_pieces(PieceType::Pawn)};
+  if (jumps_) {
+    for (uint64_t set{pawns}; set != 0; set &= set - 1) {
+      count += std::popcount(get_jump_targets(std::countr_zero(set)));
+    }
   }
+  for (uint64_t set{pieces & ~pawns}; set != 0; set &= set - 1) {
+    count += std::popcount(get_piece_targets(std::countr_zero(set)));
+  }
+  return count;
+}
 
-#define CHECK_MOVE_DIRECTION(direction, condition)                          \
-  for (int target = tile + (direction); condition; target += (direction)) { \
-    add_move(moves, tile, target);                                          \
-    if (!is_empty(target)) {                                                \
-      break;                                                                \
-    }                                                                       \
+uint64_t Board::get_jump_targets(int tile) const {
+  const uint64_t source{uint64_t{1} << static_cast<unsigned>(tile)};
+  // The jumping pawn has left its tile, so it can neither be jumped over nor
+  // block a landing
+  const uint64_t occupied{get_occupancy() & ~source};
+  const uint64_t empty{~occupied};
+  uint64_t reached{source};
+  // Flood fill: every round jumps from all tiles reached in the last one at
+  // once, and tiles reached before are never expanded again
+  for (uint64_t frontier{source}; frontier != 0;) {
+    const uint64_t landings{
+        (frontier >> 8U & occupied) >> 8U | (frontier << 8U & occupied) << 8U |
+        ((frontier & ~k_file_a) >> 1U & occupied & ~k_file_a) >> 1U |
+        ((frontier & ~k_file_h) << 1U & occupied & ~k_file_h) << 1U};
+    frontier = landings & empty & ~reached;
+    reached |= frontier;
   }
+  return reached & ~source;
+}
 
-  auto add_move = [this](Moves& moves, int tile, int target) {
-    assert(get_color(tile) != PieceColor::None);
-    if (get_color(tile) != get_color(target)) {
-      moves.data[moves.size++] = {tile, target};
+uint64_t Board::get_piece_targets(int tile) const {
+  const uint64_t occupied{get_occupancy()};
+  uint64_t attacks{};
+  switch (get_type(tile)) {
+    case PieceType::Knight:
+      attacks = k_knight_attacks[tile];
+      break;
+    case PieceType::Bishop:
+      attacks = get_bishop_attacks(tile, occupied);
+      break;
+    case PieceType::Rook:
+      attacks = get_rook_attacks(tile, occupied);
+      break;
+    case PieceType::Queen:
+      attacks = get_queen_attacks(tile, occupied);
+      break;
+    case PieceType::King:
+      attacks = k_king_attacks[tile];
+      break;
+    default:
+      break;
+  }
+  return attacks & ~get_occupancy(get_color(tile));
+}
+
+void Board::append_piece_moves(Moves& moves, uint64_t pieces) const {
+  for (; pieces != 0; pieces &= pieces - 1) {
+    const int tile{std::countr_zero(pieces)};
+    for (uint64_t targets{get_piece_targets(tile)}; targets != 0;
+         targets &= targets - 1) {
+      moves.data[moves.size++] = {tile, std::countr_zero(targets)};
     }
-  };
+  }
+}
+
+void Board::append_moves_with_jumps(Moves& moves, uint64_t pawns) const {
+  const uint64_t empty{~get_occupancy()};
+  for (; pawns != 0; pawns &= pawns - 1) {
+    const int tile{std::countr_zero(pawns)};
+    const StepTargets steps{
+        make_step_targets(uint64_t{1} << static_cast<unsigned>(tile), empty)};
+    uint64_t targets{steps.targets[0] | steps.targets[1] | steps.targets[2] |
+                     steps.targets[3] | get_jump_targets(tile)};
+    for (; targets != 0; targets &= targets - 1) {
+      moves.data[moves.size++] = {tile, std::countr_zero(targets)};
+    }
+  }
+}
+
+StepTargets Board::get_step_targets(PieceColor color) const {
+  switch (color) {
+    case PieceColor::White:
+      return get_step_targets<PieceColor::White>();
+    case PieceColor::Black:
+      return get_step_targets<PieceColor::Black>();
+    default:
+      return {};
+  }
+}
+
+void Board::generate_moves(Moves& moves, int tile) const {
+  const int row{get_tile_row(tile)};
+  const int col{get_tile_column(tile)};
+
+  const PieceType tile_type{get_type(tile)};
 
   switch (tile_type) {
     case PieceType::Pawn: {
@@ -237,6 +496,13 @@ void Board::generate_moves(Moves& moves, int tile) const {
       CHECK_PAWN_MOVE_OFFSET(-1, col != 0 && is_empty(target));
       CHECK_PAWN_MOVE_OFFSET(+1, col != 7 && is_empty(target));
 
+      if (jumps_) {
+        for (uint64_t targets{get_jump_targets(tile)}; targets != 0;
+             targets &= targets - 1) {
+          add_pawn_move(moves, tile, std::countr_zero(targets));
+        }
+      }
+
       switch (get_color(tile)) {
         case PieceColor::Black:
           // Code if color of the pawn will matter
@@ -251,11 +517,17 @@ void Board::generate_moves(Moves& moves, int tile) const {
 
 #undef CHECK_PAWN_MOVE_OFFSET
     break;
-    // Code for potential other types of pieces
+    case PieceType::Knight:
+    case PieceType::Bishop:
+    case PieceType::Rook:
+    case PieceType::Queen:
+    case PieceType::King:
+      for (uint64_t targets{get_piece_targets(tile)}; targets != 0;
+           targets &= targets - 1) {
+        moves.data[moves.size++] = {tile, std::countr_zero(targets)};
+      }
+      break;
     default:
       break;
   }
-
-#undef CHECK_MOVE_OFFSET
-#undef CHECK_MOVE_DIRECTION
 }
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "engine.hpp"
+
+#include <format>
+
+#include "bench.hpp"
+#include "protocol.hpp"
+
+Engine::Engine(std::ostream& out, const SearchOptions& options)
+    : out_{out}, ai_{options} {}
+
+Engine::~Engine() {
+  ai_.stop();
+  wait_for_search();
+}
+
+bool Engine::execute(std::string_view line) {
+  const std::vector<std::string_view> words{split_words(line)};
+  if (words.empty()) {
+    return true;
+  }
+
+  const std::string_view command{words[0]};
+  const Args args{Args{words}.subspan(1)};
+  if (command == "quit") {
+    ai_.stop();
+    wait_for_search();
+    return false;
+  }
+  if (command == "isready") {
+    send("readyok");
+  } else if (command == "stop") {
+    ai_.stop();
+    wait_for_search();
+  } else if (command == "new") {
+    wait_for_search();
+    board_.load_fen();
+    ai_.clear();
+  } else if (command == "position") {
+    wait_for_search();
+    handle_position(args);
+  } else if (command == "fen") {
+    wait_for_search();
+    send(std::format("fen {}", board_.to_fen()));
+  } else if (command == "go") {
+    wait_for_search();
+    handle_go(args);
+  } else if (command == "perft") {
+    wait_for_search();
+    handle_perft(args);
+  } else if (command == "bench") {
+    wait_for_search();
+    handle_bench(args);
+  } else if (command == "solve") {
+    wait_for_search();
+    handle_solve(args);
+  } else if (command == "variant") {
+    wait_for_search();
+    handle_variant(args);
+  } else if (command == "difficulty") {
+    wait_for_search();
+    handle_difficulty(args);
+  } else if (command == "savehash" || command == "loadhash") {
+    wait_for_search();
+    handle_hash(command, args);
+  } else {
+    send(std::format("info string unknown command {}", command));
+  }
+  return true;
+}
+
+void Engine::handle_position(Args args) {
+  if (const auto error = set_position(board_, args)) {
+    send(std::format("info string {}", *error));
+  }
+}
+
+void Engine::handle_go(Args args) {
+  SearchLimits limits;
+  if (const auto error = parse_limits(args, limits)) {
+    send(std::format("info string {}", *error));
+    return;
+  }
+
+  if (is_game_over(board_)) {
+    send("bestmove none");
+    return;
+  }
+
+  std::future<SearchResult> result{ai_.think(board_, limits)};
+  reporter_ = std::jthread{[this, result = std::move(result)]() mutable {
+    const SearchResult search_result{result.get()};
+    send(format_info(search_result));
+    send(std::format("bestmove {}", move_to_string(search_result.best_move)));
+  }};
+}
+
+void Engine::handle_perft(Args args) {
+  const std::optional<int> depth{args.empty() ? std::nullopt
+                                              : parse_int(args[0])};
+  if (!depth || *depth < 0) {
+    send("info string usage: perft <depth>");
+    return;
+  }
+  const auto start{std::chrono::steady_clock::now()};
+  const uint64_t nodes{board_.perft(*depth)};
+  const std::chrono::duration<double, std::milli> elapsed{
+      std::chrono::steady_clock::now() - start};
+  send(std::format("perft {} nodes {} time {:.0f}", *depth, nodes,
+                   elapsed.count()));
+}
+
+void Engine::handle_bench(Args args) {
+  const std::optional<int> depth{
+      args.empty() ? std::optional<int>{k_bench_depth} : parse_int(args[0])};
+  if (!depth || *depth <= 0) {
+    send("info string usage: bench [depth]");
+    return;
+  }
+  std::lock_guard<std::mutex> lock(out_mutex_);
+  run_bench(out_, *depth);
+  out_.flush();
+}
+
+void Engine::handle_solve(Args args) {
+  constexpr int k_default_nodes{10'000'000};
+  const std::optional<int> nodes{
+      args.empty() ? std::optional<int>{k_default_nodes} : parse_int(args[0])};
+  if (!nodes || *nodes <= 0) {
+    send("info string usage: solve [nodes]");
+    return;
+  }
+  if (is_game_over(board_)) {
+    send("solve none");
+    return;
+  }
+
+  const auto start{std::chrono::steady_clock::now()};
+  const SolverResult result{
+      ProofSolver{}.solve(board_, static_cast<uint64_t>(*nodes))};
+  const std::chrono::duration<double, std::milli> elapsed{
+      std::chrono::steady_clock::now() - start};
+  std::string outcome;
+  switch (result.outcome) {
+    case SolverOutcome::Win:
+      outcome = std::format("win {}", move_to_string(result.best_move));
+      break;
+    case SolverOutcome::NoWin:
+      outcome = "nowin";
+      break;
+    case SolverOutcome::Unknown:
+      outcome = "unknown";
+      break;
+  }
+  send(std::format("solve {} nodes {} time {:.0f}", outcome, result.nodes,
+                   elapsed.count()));
+}
+
+void Engine::handle_variant(Args args) {
+  if (args.size() != 1 || (args[0] != "steps" && args[0] != "jumps")) {
+    send("info string usage: variant steps|jumps");
+    return;
+  }
+  board_.set_jumps(args[0] == "jumps");
+  board_.load_fen();
+  // Table entries were scored under the other rules
+  ai_.clear();
+}
+
+void Engine::handle_difficulty(Args args) {
+  const std::optional<Difficulty> difficulty{
+      args.size() == 1 ? parse_difficulty(args[0]) : std::nullopt};
+  if (!difficulty) {
+    send("info string usage: difficulty easy|medium|hard|max");
+    return;
+  }
+  ai_.set_difficulty(*difficulty);
+}
+
+void Engine::handle_hash(std::string_view command, Args args) {
+  if (args.size() != 1) {
+    send(std::format("info string usage: {} <file>", command));
+    return;
+  }
+  const std::string path{args[0]};
+  const bool is_done{command == "savehash" ? ai_.save_hash(path)
+                                           : ai_.load_hash(path)};
+  send(std::format("info string {} {} {}", command, path,
+                   is_done ? "ok" : "failed"));
+}
+
+void Engine::wait_for_search() {
+  if (reporter_.joinable()) {
+    reporter_.join();
+  }
+}
+
+void Engine::send(std::string_view line) {
+  std::lock_guard<std::mutex> lock(out_mutex_);
+  out_ << line << std::endl;
+}
@@ -0,0 +1,194 @@
+#include "engine_service.hpp"
+
+#include <format>
+
+#include "protocol.hpp"
+
+EngineService::EngineService(ThreadPool& pool, const Options& options)
+    : pool_{pool}, options_{options} {}
+
+void EngineService::execute(std::string_view line, const Reply& reply,
+                            uint64_t owner) {
+  const std::vector<std::string_view> words{split_words(line)};
+  if (words.empty()) {
+    reply("error empty request");
+    return;
+  }
+
+  if (words[0] == "new") {
+    create_session(owner, reply);
+    return;
+  }
+
+  const std::optional<int> id{parse_int(words[0])};
+  const std::shared_ptr<Session> session{
+      id ? find_session(static_cast<uint64_t>(*id)) : nullptr};
+  if (session == nullptr || words.size() < 2) {
+    reply(std::format("{} error unknown game", words[0]));
+    return;
+  }
+
+  const std::string_view command{words[1]};
+  const ProtocolArgs args{ProtocolArgs{words}.subspan(2)};
+  auto reply_error = [&reply, id](std::string_view error) {
+    reply(std::format("{} error {}", *id, error));
+  };
+
+  if (command == "close") {
+    {
+      std::lock_guard<std::mutex> lock(sessions_mutex_);
+      close_session(static_cast<uint64_t>(*id), *session);
+    }
+    reply(std::format("{} closed", *id));
+    return;
+  }
+
+  // The board belongs to the search while it runs
+  {
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    if (session->is_searching) {
+      reply_error("busy");
+      return;
+    }
+  }
+
+  if (command == "position") {
+    if (const auto error = set_position(session->board, args)) {
+      reply_error(*error);
+      return;
+    }
+    reply(std::format("{} ok", *id));
+  } else if (command == "go") {
+    SearchLimits limits;
+    if (const auto error = parse_limits(args, limits)) {
+      reply_error(*error);
+      return;
+    }
+    go(static_cast<uint64_t>(*id), session, limits, reply);
+  } else if (command == "difficulty") {
+    const std::optional<Difficulty> difficulty{
+        args.size() == 1 ? parse_difficulty(args[0]) : std::nullopt};
+    if (!difficulty) {
+      reply_error("usage: difficulty easy|medium|hard|max");
+      return;
+    }
+    session->ai.set_difficulty(*difficulty);
+    reply(std::format("{} ok", *id));
+  } else {
+    reply_error(std::format("unknown command {}", command));
+  }
+}
+
+void EngineService::close_games(uint64_t owner) {
+  std::lock_guard<std::mutex> lock(sessions_mutex_);
+  std::vector<std::pair<uint64_t, std::shared_ptr<Session>>> owned;
+  for (const auto& [id, session] : sessions_) {
+    if (session != nullptr && session->owner == owner) {
+      owned.emplace_back(id, session);
+    }
+  }
+  for (const auto& [id, session] : owned) {
+    close_session(id, *session);
+  }
+}
+
+size_t EngineService::get_game_count() const {
+  std::lock_guard<std::mutex> lock(sessions_mutex_);
+  return sessions_.size();
+}
+
+void EngineService::go(uint64_t id, const std::shared_ptr<Session>& session,
+                       SearchLimits limits, const Reply& reply) {
+  if (is_game_over(session->board)) {
+    reply(std::format("{} bestmove none", id));
+    return;
+  }
+
+  // With a clock the search budgets the move itself, capped like any other
+  if (limits.movetime.count() == 0) {
+    limits.movetime = limits.has_clock(session->board.get_turn())
+                          ? options_.max_movetime
+                          : options_.default_movetime;
+  }
+  limits.movetime = std::min(limits.movetime, options_.max_movetime);
+
+  {
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    session->is_searching = true;
+  }
+
+  const Clock::time_point arrival{Clock::now()};
+  pool_.submit([this, id, session, limits, reply, arrival]() mutable {
+    {
+      std::lock_guard<std::mutex> lock(sessions_mutex_);
+      if (session->is_cancelled) {
+        return;
+      }
+    }
+    // Time spent waiting in the queue counts against the budget
+    const auto waited{std::chrono::duration_cast<std::chrono::milliseconds>(
+        Clock::now() - arrival)};
+    limits.movetime =
+        std::max(limits.movetime - waited, std::chrono::milliseconds{1});
+    for (std::chrono::milliseconds& clock : limits.clock) {
+      if (clock.count() != 0) {
+        clock = std::max(clock - waited, std::chrono::milliseconds{1});
+      }
+    }
+
+    // A close from here on has already stopped the AI
+    const SearchResult result{
+        session->ai.find_best_move_unless_stopped(session->board, limits)};
+    {
+      std::lock_guard<std::mutex> lock(sessions_mutex_);
+      session->is_searching = false;
+      if (session->is_cancelled) {
+        return;
+      }
+    }
+    reply(std::format("{} bestmove {} depth {} nodes {} time {:.0f}", id,
+                      move_to_string(result.best_move), result.stats.depth,
+                      result.stats.nodes, result.stats.elapsed_ms));
+  });
+}
+
+void EngineService::create_session(uint64_t owner, const Reply& reply) {
+  uint64_t id{};
+  {
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    if (sessions_.size() < options_.max_games) {
+      id = next_id_++;
+      sessions_.emplace(id, nullptr);
+    }
+  }
+  if (id == 0) {
+    reply("error too many games");
+    return;
+  }
+
+  // Outside the lock: the tables take a while to allocate
+  SearchOptions search_options;
+  search_options.hash_size_mb = options_.hash_size_mb;
+  search_options.solver_hash_size_mb = options_.solver_hash_size_mb;
+  search_options.log_search = false;
+  auto session{std::make_shared<Session>(search_options, owner)};
+
+  {
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    sessions_[id] = std::move(session);
+  }
+  reply(std::format("{} created", id));
+}
+
+void EngineService::close_session(uint64_t id, Session& session) {
+  session.is_cancelled = true;
+  session.ai.stop();
+  sessions_.erase(id);
+}
+
+std::shared_ptr<EngineService::Session> EngineService::find_session(
+    uint64_t id) const {
+  std::lock_guard<std::mutex> lock(sessions_mutex_);
+  const auto it{sessions_.find(id)};
+  return it != sessions_.end() ? it->second : nullptr;
+}
@@ -0,0 +1,44 @@
+#include "evaluation.hpp"
+
+template <PieceColor Us>
+int evaluate(const Board& board) {
+  int white_score{};
+  int black_score{};
+  int white_straggler{};
+  int black_straggler{};
+  for (int tile = 0; tile < 64; tile++) {
+    switch (board.get_color(tile)) {
+      case PieceColor::White:
+        white_score += get_pst_value<PieceColor::White>(tile);
+        white_straggler =
+            std::max(white_straggler,
+                     get_straggler_distance<PieceColor::White>(tile));
+        break;
+      case PieceColor::Black:
+        black_score += get_pst_value<PieceColor::Black>(tile);
+        black_straggler =
+            std::max(black_straggler,
+                     get_straggler_distance<PieceColor::Black>(tile));
+        break;
+      default:
+        break;
+    }
+  }
+
+  const int score{(white_score - black_score) -
+                  k_straggler_weight * (white_straggler - black_straggler)};
+  if constexpr (Us == PieceColor::White) {
+    return score;
+  } else {
+    return -score;
+  }
+}
+
+template int evaluate<PieceColor::White>(const Board& board);
+template int evaluate<PieceColor::Black>(const Board& board);
+
+int evaluate(const Board& board) {
+  return board.get_turn() == PieceColor::White
+             ? evaluate<PieceColor::White>(board)
+             : evaluate<PieceColor::Black>(board);
+}
@@ -34,6 +34,9 @@ Game::Game(GLFWwindow* window) : renderer_(window, camera_) {
   }
   set_camera_target_position(camera_target_position);
 
+  records_.open(std::string{k_record_path});
+  book_.open(std::string{k_book_path});
+
   // Makes it so camera is still for a split second before game starts
   is_camera_moving_ = false;
   active_move_.is_completed = true;
@@ -97,14 +100,17 @@ void Game::run() {
 void Game::update() {
   process_camera_movement();
 
-  if (game_over_ || ai_.is_thinking()) {
-    // No logic update is needed if game over or AI deciding its move
+  if (game_over_) {
     return;
   }
 
-  // Commence AI moving their piece
-  if (ai_.has_found_move()) {
-    set_active_move(ai_.get_best_move());
+  if (is_ai_thinking()) {
+    // No logic update is needed while AI is deciding its move
+    if (ai_move_.wait_for(0s) != std::future_status::ready) {
+      return;
+    }
+    // Commence AI moving their piece
+    set_active_move(ai_move_.get().best_move);
   }
 
   process_active_move();
@@ -289,10 +295,14 @@ void Game::process_active_move() {
     if (board_.is_in_checkmate()) {
       LOGF("GAME", "{} won!",
            board_.get_turn() == PieceColor::White ? "Black" : "White");
+    } else if (board_.is_draw()) {
+      LOG("GAME", "Draw by repetition");
     }
-    if (board_.is_in_checkmate()) {
+    if (board_.is_in_checkmate() || board_.is_draw()) {
       enable_cursor();
       game_over_ = true;
+      records_.write(make_game_record(board_));
+      records_.flush();
       return;
     }
 
@@ -302,7 +312,7 @@ void Game::process_active_move() {
         return;
       }
 
-      ai_.think(board_, blackBase_, whiteBase_);
+      start_ai_turn();
     }
     return;
   }
@@ -317,6 +327,7 @@ void Game::process_active_move() {
     } else {
       PieceType promotion{};
       board_.make_move({active_move_.tile, active_move_.target});
+      log_book_moves();
     }
     active_move_.angle = 0.0F;
     active_move_.is_completed = true;
@@ -354,6 +365,19 @@ void Game::set_active_move(const Move& move, bool is_undo) {
   disable_cursor();
 }
 
+void Game::log_book_moves() const {
+  if (!book_.is_open()) {
+    return;
+  }
+  for (const PositionStats& stats : book_.find(board_.get_hash())) {
+    LOGF("BOOK", "{}: {} games +{} ={} -{} score {:.1f}%",
+         move_to_string(stats.get_move()), stats.get_count(), stats.wins,
+         stats.draws, stats.losses, 100.0 * stats.get_score());
+  }
+}
+
+void Game::start_ai_turn() { ai_move_ = ai_.think(board_); }
+
 void Game::undo() {
   if (const auto& records = board_.get_records(); !records.empty()) {
     set_active_move(records.back().move, true);
@@ -405,10 +429,10 @@ void Game::mouse_button_callback(GLFWwindow* window, int button, int action,
         game->set_active_move({game->selected_tile_, tile});
       } else if (get_piece_type(piece) != PieceType::None) {
         game->clear_selections();
-        if (game->board_.get_records().empty() && !game->ai_.is_thinking()) {
+        if (game->board_.get_records().empty() && !game->is_ai_thinking()) {
           game->ai_color_ = get_opposite_color(game->board_.get_color(tile));
           if (game->ai_color_ == PieceColor::White) {
-            game->ai_.think(game->board_, game->blackBase_, game->whiteBase_);
+            game->start_ai_turn();
             game->disable_cursor();
           }
           game->set_camera_target_position(
@@ -490,7 +514,20 @@ void Game::key_callback(GLFWwindow* window, int key, int /*scancode*/,
   }
   if (key == GLFW_KEY_U && action == GLFW_PRESS) {
     game->undo();
-  } else if (key == GLFW_KEY_R && action == GLFW_PRESS) {
+  } else if (key == GLFW_KEY_D && action == GLFW_PRESS) {
+    game->difficulty_ = static_cast<Difficulty>(
+        (to_underlying(game->difficulty_) + 1) % k_difficulty_presets.size());
+    game->ai_.set_difficulty(game->difficulty_);
+    LOGF("GAME", "Difficulty {}",
+         k_difficulty_presets[to_underlying(game->difficulty_)].name);
+  } else if ((key == GLFW_KEY_R || key == GLFW_KEY_J) &&
+             action == GLFW_PRESS) {
+    // J switches between plain steps and the leapfrog variant
+    if (key == GLFW_KEY_J) {
+      game->board_.set_jumps(!game->board_.has_jumps());
+      game->ai_.clear();
+      LOGF("GAME", "Jumps {}", game->board_.has_jumps() ? "on" : "off");
+    }
     game->board_.load_fen();
     game->ai_color_ = PieceColor::None;
     game->game_over_ = false;
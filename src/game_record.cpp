@@ -0,0 +1,274 @@
+#include "game_record.hpp"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "log.hpp"
+
+namespace {
+constexpr std::string_view k_magic{"CPGR"};
+constexpr uint16_t k_version{1};
+constexpr size_t k_file_header_size{8};
+constexpr size_t k_game_header_size{4};
+// In the result byte
+constexpr uint8_t k_jumps_flag{0x80};
+
+void append_u16(std::string& buffer, uint16_t value) {
+  buffer.push_back(static_cast<char>(value & 0xFF));
+  buffer.push_back(static_cast<char>(value >> 8));
+}
+
+void append_u64(std::string& buffer, uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    buffer.push_back(static_cast<char>(value >> (i * 8) & 0xFF));
+  }
+}
+
+uint8_t read_u8(const std::byte* data) {
+  return std::to_integer<uint8_t>(data[0]);
+}
+
+uint16_t read_u16(const std::byte* data) {
+  return static_cast<uint16_t>(read_u8(data) | read_u8(data + 1) << 8);
+}
+
+uint64_t read_u64(const std::byte* data) {
+  uint64_t value{};
+  for (int i = 0; i < 8; i++) {
+    value |= static_cast<uint64_t>(read_u8(data + i)) << (i * 8);
+  }
+  return value;
+}
+}  // namespace
+
+GameRecord make_game_record(const Board& board, std::string start_fen) {
+  GameRecord record;
+  record.start_fen = std::move(start_fen);
+  record.jumps = board.has_jumps();
+  record.moves.reserve(board.get_records().size());
+  for (const auto& move_record : board.get_records()) {
+    record.moves.push_back(move_record.move);
+  }
+  if (board.is_in_checkmate()) {
+    // Whoever moved last has won
+    record.result = board.get_turn() == PieceColor::White
+                        ? GameResult::BlackWins
+                        : GameResult::WhiteWins;
+  } else if (board.is_draw()) {
+    record.result = GameResult::Draw;
+  }
+  return record;
+}
+
+bool for_each_position(
+    const std::vector<std::string>& paths, int skip_plies,
+    const std::function<void(const Board&, float)>& visit) {
+  Board board;
+  for (const std::string& path : paths) {
+    GameRecordReader reader;
+    if (!reader.open(path)) {
+      return false;
+    }
+
+    size_t jump_games{};
+    for (size_t i = 0; i < reader.get_size(); i++) {
+      const GameView game{reader.get_game(i)};
+      float result{0.5F};
+      switch (game.get_result()) {
+        case GameResult::None:
+          continue;
+        case GameResult::WhiteWins:
+          result = 1.0F;
+          break;
+        case GameResult::BlackWins:
+          result = 0.0F;
+          break;
+        case GameResult::Draw:
+          break;
+      }
+
+      if (!game.load_start(board)) {
+        continue;
+      }
+      jump_games += board.has_jumps() ? 1 : 0;
+      for (size_t ply = 0; ply < game.get_move_count(); ply++) {
+        const Move move{game.get_move(ply)};
+        if (!is_legal_move(board, move)) {
+          break;
+        }
+        if (ply >= static_cast<size_t>(skip_plies)) {
+          visit(board, result);
+        }
+        board.move(move);
+      }
+    }
+    if (jump_games != 0) {
+      LOGF("RECORD", "{}: {} of {} games use the leapfrog variant", path,
+           jump_games, reader.get_size());
+    }
+  }
+  return true;
+}
+
+bool is_legal_move(Board& board, Move move) {
+  Moves moves;
+  board.generate_all_legal_moves(moves);
+  const auto end{moves.data.begin() + moves.size};
+  return std::find(moves.data.begin(), end, move) != end;
+}
+
+bool GameRecordWriter::open(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::error_code error;
+  const uintmax_t size{std::filesystem::file_size(path, error)};
+  offset_ = error ? 0 : size;
+
+  data_.open(path, std::ios::binary | std::ios::app);
+  index_.open(path + ".idx", std::ios::binary | std::ios::app);
+  if (!data_ || !index_) {
+    LOGF("RECORD", "Failed to open {}", path);
+    data_.close();
+    index_.close();
+    return false;
+  }
+
+  if (offset_ == 0) {
+    buffer_ = k_magic;
+    append_u16(buffer_, k_version);
+    append_u16(buffer_, 0);
+    data_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    offset_ = buffer_.size();
+  }
+  return true;
+}
+
+bool GameRecordWriter::write(const GameRecord& record) {
+  if (record.moves.size() > UINT16_MAX || record.start_fen.size() > UINT8_MAX) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!data_.is_open()) {
+    return false;
+  }
+  buffer_.clear();
+  append_u16(buffer_, static_cast<uint16_t>(record.moves.size()));
+  buffer_.push_back(static_cast<char>(to_underlying(record.result) |
+                                     (record.jumps ? k_jumps_flag : 0U)));
+  buffer_.push_back(static_cast<char>(record.start_fen.size()));
+  buffer_ += record.start_fen;
+  for (const Move move : record.moves) {
+    append_u16(buffer_, pack_move(move));
+  }
+  data_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+
+  const uint64_t game_offset{offset_};
+  offset_ += buffer_.size();
+  buffer_.clear();
+  append_u64(buffer_, game_offset);
+  index_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  return data_.good() && index_.good();
+}
+
+void GameRecordWriter::flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  data_.flush();
+  index_.flush();
+}
+
+size_t GameView::get_move_count() const { return read_u16(data_); }
+
+GameResult GameView::get_result() const {
+  return static_cast<GameResult>(read_u8(data_ + 2) & ~k_jumps_flag);
+}
+
+bool GameView::has_jumps() const {
+  return (read_u8(data_ + 2) & k_jumps_flag) != 0;
+}
+
+std::string_view GameView::get_start_fen() const {
+  return {reinterpret_cast<const char*>(data_ + k_game_header_size),
+          read_u8(data_ + 3)};
+}
+
+Move GameView::get_move(size_t ply) const {
+  return unpack_move(
+      read_u16(data_ + k_game_header_size + read_u8(data_ + 3) + ply * 2));
+}
+
+bool GameView::load_start(Board& board) const {
+  board.set_jumps(has_jumps());
+  const std::string_view fen{get_start_fen()};
+  if (fen.empty()) {
+    board.load_fen();
+    return true;
+  }
+  return board.load_fen(fen);
+}
+
+bool GameView::replay(Board& board) const {
+  if (!load_start(board)) {
+    return false;
+  }
+  for (size_t ply = 0; ply < get_move_count(); ply++) {
+    const Move move{get_move(ply)};
+    if (!is_legal_move(board, move)) {
+      return false;
+    }
+    board.make_move(move);
+  }
+  return true;
+}
+
+bool GameRecordReader::open(const std::string& path) {
+  offsets_.clear();
+  if (!file_.open(path)) {
+    LOGF("RECORD", "Failed to open {}", path);
+    return false;
+  }
+  const std::span<const std::byte> data{file_.get_data()};
+  if (data.size() < k_file_header_size ||
+      std::string_view{reinterpret_cast<const char*>(data.data()),
+                       k_magic.size()} != k_magic ||
+      read_u16(data.data() + 4) != k_version) {
+    LOGF("RECORD", "{} is not a version {} game record file", path, k_version);
+    file_.close();
+    return false;
+  }
+
+  uint64_t offset{k_file_header_size};
+  if (MappedFile index; index.open(path + ".idx")) {
+    const std::span<const std::byte> entries{index.get_data()};
+    offsets_.reserve(entries.size() / 8);
+    for (size_t i = 0; i + 8 <= entries.size(); i += 8) {
+      const uint64_t game_offset{read_u64(entries.data() + i)};
+      if (game_offset < offset || game_offset >= data.size()) {
+        break;
+      }
+      offsets_.push_back(game_offset);
+      offset = game_offset + k_game_header_size;
+    }
+    if (!offsets_.empty()) {
+      // Rescan from the last indexed game on, in case the index lags behind
+      offset = offsets_.back();
+      offsets_.pop_back();
+    }
+  }
+  scan(offset);
+  return true;
+}
+
+void GameRecordReader::scan(uint64_t offset) {
+  const std::span<const std::byte> data{file_.get_data()};
+  while (offset + k_game_header_size <= data.size()) {
+    const std::byte* game{data.data() + offset};
+    const uint64_t size{k_game_header_size + read_u8(game + 3) +
+                        read_u16(game) * uint64_t{2}};
+    if (offset + size > data.size()) {
+      // Truncated by an interrupted write
+      break;
+    }
+    offsets_.push_back(offset);
+    offset += size;
+  }
+}
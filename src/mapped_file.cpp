@@ -0,0 +1,124 @@
+#include "mapped_file.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept { swap(other); }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    close();
+    swap(other);
+  }
+  return *this;
+}
+
+void MappedFile::swap(MappedFile& other) noexcept {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  std::swap(is_open_, other.is_open_);
+#ifdef _WIN32
+  std::swap(file_, other.file_);
+  std::swap(mapping_, other.mapping_);
+#endif
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path) {
+  close();
+  HANDLE file{CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                          OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr)};
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size{};
+  if (GetFileSizeEx(file, &size) == 0) {
+    CloseHandle(file);
+    return false;
+  }
+  file_ = file;
+  is_open_ = true;
+  if (size.QuadPart == 0) {
+    return true;
+  }
+
+  mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_ == nullptr) {
+    close();
+    return false;
+  }
+  data_ = static_cast<const std::byte*>(
+      MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  if (data_ == nullptr) {
+    close();
+    return false;
+  }
+  size_ = static_cast<size_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::close() {
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_ != nullptr) {
+    CloseHandle(mapping_);
+  }
+  if (file_ != nullptr) {
+    CloseHandle(file_);
+  }
+  data_ = nullptr;
+  mapping_ = nullptr;
+  file_ = nullptr;
+  size_ = 0;
+  is_open_ = false;
+}
+#else
+bool MappedFile::open(const std::string& path) {
+  close();
+  const int file{::open(path.c_str(), O_RDONLY)};
+  if (file < 0) {
+    return false;
+  }
+  struct stat status {};
+  if (fstat(file, &status) != 0) {
+    ::close(file);
+    return false;
+  }
+
+  is_open_ = true;
+  if (status.st_size > 0) {
+    const auto size{static_cast<size_t>(status.st_size)};
+    void* data{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0)};
+    if (data == MAP_FAILED) {
+      is_open_ = false;
+    } else {
+      madvise(data, size, MADV_SEQUENTIAL);
+      data_ = static_cast<const std::byte*>(data);
+      size_ = size;
+    }
+  }
+  // The mapping stays valid after the descriptor is closed
+  ::close(file);
+  return is_open_;
+}
+
+void MappedFile::close() {
+  if (data_ != nullptr) {
+    munmap(const_cast<std::byte*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  is_open_ = false;
+}
+#endif
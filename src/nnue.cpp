@@ -0,0 +1,237 @@
+#include "nnue.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#include "board.hpp"
+#include "evaluation.hpp"
+#include "log.hpp"
+#include "simd.hpp"
+
+#ifdef CORNERPAWNS_X86
+#include <immintrin.h>
+#endif
+
+static_assert(std::endian::native == std::endian::little,
+              "network files are read as little-endian arrays");
+static_assert(k_nnue_hidden % 16 == 0);
+
+namespace {
+constexpr std::string_view k_magic{"CPNN"};
+constexpr uint32_t k_version{1};
+
+using Hidden = std::array<int16_t, k_nnue_hidden>;
+
+int32_t forward_scalar(const Hidden& us, const Hidden& them,
+                       const int16_t* weights) {
+  int32_t sum{};
+  for (size_t i = 0; i < k_nnue_hidden; i++) {
+    sum += std::clamp<int32_t>(us[i], 0, NnueParameters::k_activation_max) *
+           weights[i];
+    sum += std::clamp<int32_t>(them[i], 0, NnueParameters::k_activation_max) *
+           weights[k_nnue_hidden + i];
+  }
+  return sum;
+}
+
+#ifdef CORNERPAWNS_X86
+CORNERPAWNS_TARGET("avx2")
+__m256i load_clipped_avx2(const int16_t* values) {
+  const __m256i loaded{
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(values))};
+  return _mm256_min_epi16(
+      _mm256_max_epi16(loaded, _mm256_setzero_si256()),
+      _mm256_set1_epi16(NnueParameters::k_activation_max));
+}
+
+CORNERPAWNS_TARGET("avx2")
+int32_t forward_avx2(const Hidden& us, const Hidden& them,
+                     const int16_t* weights) {
+  __m256i sum{_mm256_setzero_si256()};
+  for (size_t i = 0; i < k_nnue_hidden; i += 16) {
+    const __m256i us_weights{
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(&weights[i]))};
+    const __m256i them_weights{_mm256_load_si256(
+        reinterpret_cast<const __m256i*>(&weights[k_nnue_hidden + i]))};
+    // Pairwise int16 products summed into int32 lanes
+    sum = _mm256_add_epi32(
+        sum, _mm256_madd_epi16(load_clipped_avx2(&us[i]), us_weights));
+    sum = _mm256_add_epi32(
+        sum, _mm256_madd_epi16(load_clipped_avx2(&them[i]), them_weights));
+  }
+  __m128i total{_mm_add_epi32(_mm256_castsi256_si128(sum),
+                              _mm256_extracti128_si256(sum, 1))};
+  total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0x4E));
+  total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0xB1));
+  return _mm_cvtsi128_si32(total);
+}
+#endif
+
+template <typename T>
+void read_array(std::ifstream& file, T* data, size_t count) {
+  file.read(reinterpret_cast<char*>(data),
+            static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+template <typename T>
+void write_array(std::ofstream& file, const T* data, size_t count) {
+  file.write(reinterpret_cast<const char*>(data),
+             static_cast<std::streamsize>(count * sizeof(T)));
+}
+}  // namespace
+
+bool Nnue::load(const std::string& path) {
+  std::ifstream file{path, std::ios::binary};
+  std::array<char, 4> magic{};
+  uint32_t version{};
+  uint32_t hidden{};
+  read_array(file, magic.data(), magic.size());
+  read_array(file, &version, 1);
+  read_array(file, &hidden, 1);
+  if (!file || std::string_view{magic.data(), magic.size()} != k_magic ||
+      version != k_version || hidden != k_nnue_hidden) {
+    LOGF("NNUE", "{} is not a version {} network with {} hidden units", path,
+         k_version, k_nnue_hidden);
+    return false;
+  }
+
+  NnueParameters parameters;
+  read_array(file, parameters.hidden_biases.data(), k_nnue_hidden);
+  for (Hidden& weights : parameters.hidden_weights) {
+    read_array(file, weights.data(), k_nnue_hidden);
+  }
+  read_array(file, parameters.output_weights.data(),
+             parameters.output_weights.size());
+  read_array(file, &parameters.output_bias, 1);
+  read_array(file, &parameters.output_scale, 1);
+  if (!file) {
+    LOGF("NNUE", "{} is truncated", path);
+    return false;
+  }
+  set_parameters(std::move(parameters));
+  LOGF("NNUE", "Loaded {}", path);
+  return true;
+}
+
+bool Nnue::save(const std::string& path) const {
+  std::ofstream file{path, std::ios::binary};
+  const uint32_t hidden{k_nnue_hidden};
+  write_array(file, k_magic.data(), k_magic.size());
+  write_array(file, &k_version, 1);
+  write_array(file, &hidden, 1);
+  write_array(file, parameters_.hidden_biases.data(), k_nnue_hidden);
+  for (const Hidden& weights : parameters_.hidden_weights) {
+    write_array(file, weights.data(), k_nnue_hidden);
+  }
+  write_array(file, parameters_.output_weights.data(),
+              parameters_.output_weights.size());
+  write_array(file, &parameters_.output_bias, 1);
+  write_array(file, &parameters_.output_scale, 1);
+  return file.good();
+}
+
+void Nnue::set_parameters(NnueParameters parameters) {
+  parameters_ = std::move(parameters);
+  for (size_t i = 0; i < output_weights_.size(); i++) {
+    output_weights_[i] = parameters_.output_weights[i];
+  }
+  is_loaded_ = true;
+}
+
+void Nnue::init_random(uint64_t seed) {
+  std::mt19937_64 generator{seed};
+  auto random = [&generator](int low, int high) {
+    return std::uniform_int_distribution<int>{low, high}(generator);
+  };
+  NnueParameters parameters;
+  for (int16_t& bias : parameters.hidden_biases) {
+    bias = static_cast<int16_t>(random(0, 40));
+  }
+  for (Hidden& weights : parameters.hidden_weights) {
+    for (int16_t& weight : weights) {
+      weight = static_cast<int16_t>(random(-20, 20));
+    }
+  }
+  for (int8_t& weight : parameters.output_weights) {
+    weight = static_cast<int8_t>(random(-60, 60));
+  }
+  parameters.output_scale = 100;
+  set_parameters(std::move(parameters));
+}
+
+size_t Nnue::get_feature(PieceColor perspective, PieceColor color, int tile) {
+  const int own_tile{perspective == PieceColor::White ? tile
+                                                      : transpose_tile(tile)};
+  return static_cast<size_t>((color == perspective ? 0 : 64) + own_tile);
+}
+
+void Nnue::refresh(const Board& board, NnueAccumulator& accumulator) const {
+  accumulator.values.fill(parameters_.hidden_biases);
+  for (int tile = 0; tile < 64; tile++) {
+    if (!board.is_empty(tile)) {
+      add_piece(accumulator, board.get_tile(tile), tile);
+    }
+  }
+}
+
+void Nnue::add_piece(NnueAccumulator& accumulator, Piece piece,
+                     int tile) const {
+  for (const PieceColor perspective : {PieceColor::Black, PieceColor::White}) {
+    Hidden& values{accumulator.values[get_color_index(perspective)]};
+    const Hidden& weights{parameters_.hidden_weights[get_feature(
+        perspective, get_piece_color(piece), tile)]};
+    for (size_t i = 0; i < k_nnue_hidden; i++) {
+      values[i] = static_cast<int16_t>(values[i] + weights[i]);
+    }
+  }
+}
+
+void Nnue::remove_piece(NnueAccumulator& accumulator, Piece piece,
+                        int tile) const {
+  for (const PieceColor perspective : {PieceColor::Black, PieceColor::White}) {
+    Hidden& values{accumulator.values[get_color_index(perspective)]};
+    const Hidden& weights{parameters_.hidden_weights[get_feature(
+        perspective, get_piece_color(piece), tile)]};
+    for (size_t i = 0; i < k_nnue_hidden; i++) {
+      values[i] = static_cast<int16_t>(values[i] - weights[i]);
+    }
+  }
+}
+
+void Nnue::move_piece(NnueAccumulator& accumulator, Piece piece, int from,
+                      int to) const {
+  const PieceColor color{get_piece_color(piece)};
+  for (const PieceColor perspective : {PieceColor::Black, PieceColor::White}) {
+    Hidden& values{accumulator.values[get_color_index(perspective)]};
+    const Hidden& removed{
+        parameters_.hidden_weights[get_feature(perspective, color, from)]};
+    const Hidden& added{
+        parameters_.hidden_weights[get_feature(perspective, color, to)]};
+    for (size_t i = 0; i < k_nnue_hidden; i++) {
+      values[i] = static_cast<int16_t>(values[i] - removed[i] + added[i]);
+    }
+  }
+}
+
+int Nnue::evaluate(const NnueAccumulator& accumulator,
+                   PieceColor turn) const {
+  const Hidden& us{accumulator.values[get_color_index(turn)]};
+  const Hidden& them{
+      accumulator.values[get_color_index(get_opposite_color(turn))]};
+#ifdef CORNERPAWNS_X86
+  static const bool has_avx2{get_simd_level() >= SimdLevel::Avx2};
+  const int32_t output{has_avx2
+                           ? forward_avx2(us, them, output_weights_.data())
+                           : forward_scalar(us, them, output_weights_.data())};
+#else
+  const int32_t output{forward_scalar(us, them, output_weights_.data())};
+#endif
+  return static_cast<int>(
+      (static_cast<int64_t>(output) + parameters_.output_bias) *
+      parameters_.output_scale /
+      (NnueParameters::k_activation_max *
+       NnueParameters::k_output_weight_scale));
+}
@@ -0,0 +1,234 @@
+#include "nnue_trainer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <span>
+
+#include "game_record.hpp"
+#include "log.hpp"
+
+namespace {
+// Keeps the quantized values inside int16 and int8
+constexpr float k_max_hidden_weight{8.0F};
+constexpr float k_max_output_weight{1.98F};
+
+float sigmoid(float value) { return 1.0F / (1.0F + std::exp(-value)); }
+
+template <typename T>
+T quantize_value(double value, double scale) {
+  return static_cast<T>(std::lround(value * scale));
+}
+}  // namespace
+
+NnueTrainer::NnueTrainer(NnueTrainerConfig config)
+    : config_{std::move(config)}, generator_{config_.seed} {
+  std::uniform_real_distribution<float> distribution{-0.1F, 0.1F};
+  for (auto& weights : parameters_.hidden_weights) {
+    for (float& weight : weights) {
+      weight = distribution(generator_);
+    }
+  }
+  for (float& weight : parameters_.output_weights) {
+    weight = distribution(generator_);
+  }
+  parameters_.hidden_biases.fill(0.1F);
+}
+
+bool NnueTrainer::load() {
+  const bool is_loaded{for_each_position(
+      config_.record_paths, config_.skip_plies,
+      [this](const Board& board, float result) {
+        add_position(board, result);
+      })};
+  LOGF("NNUE", "{} positions loaded", results_.size());
+  return is_loaded && !results_.empty();
+}
+
+void NnueTrainer::add_position(const Board& board, float white_result) {
+  samples_.push_back(make_sample(board));
+  results_.push_back(board.get_turn() == PieceColor::White
+                         ? white_result
+                         : 1.0F - white_result);
+}
+
+NnueTrainer::Sample NnueTrainer::make_sample(const Board& board) {
+  Sample sample{};
+  const PieceColor turn{board.get_turn()};
+  for (int tile = 0; tile < 64 && sample.count < k_max_pieces; tile++) {
+    const PieceColor color{board.get_color(tile)};
+    if (color == PieceColor::None) {
+      continue;
+    }
+    sample.features[0][sample.count] =
+        static_cast<uint8_t>(Nnue::get_feature(turn, color, tile));
+    sample.features[1][sample.count] = static_cast<uint8_t>(
+        Nnue::get_feature(get_opposite_color(turn), color, tile));
+    sample.count++;
+  }
+  return sample;
+}
+
+float NnueTrainer::forward(
+    const Sample& sample,
+    std::array<std::array<float, k_hidden>, 2>& hidden) const {
+  float output{parameters_.output_bias};
+  for (size_t side = 0; side < 2; side++) {
+    hidden[side] = parameters_.hidden_biases;
+    for (size_t i = 0; i < sample.count; i++) {
+      const auto& weights{
+          parameters_.hidden_weights[sample.features[side][i]]};
+      for (size_t unit = 0; unit < k_hidden; unit++) {
+        hidden[side][unit] += weights[unit];
+      }
+    }
+    for (size_t unit = 0; unit < k_hidden; unit++) {
+      output += std::clamp(hidden[side][unit], 0.0F, 1.0F) *
+                parameters_.output_weights[side * k_hidden + unit];
+    }
+  }
+  return output;
+}
+
+float NnueTrainer::accumulate_gradient(const Sample& sample, float result,
+                                       Parameters& gradient) const {
+  std::array<std::array<float, k_hidden>, 2> hidden{};
+  const float prediction{sigmoid(forward(sample, hidden))};
+  const float error{prediction - result};
+  const float output_gradient{2.0F * error * prediction * (1.0F - prediction)};
+
+  gradient.output_bias += output_gradient;
+  for (size_t side = 0; side < 2; side++) {
+    std::array<float, k_hidden> hidden_gradient{};
+    for (size_t unit = 0; unit < k_hidden; unit++) {
+      const float value{hidden[side][unit]};
+      const size_t output_index{side * k_hidden + unit};
+      gradient.output_weights[output_index] +=
+          output_gradient * std::clamp(value, 0.0F, 1.0F);
+      // The clipped ReLU only passes gradients inside its linear range
+      if (value > 0.0F && value < 1.0F) {
+        hidden_gradient[unit] =
+            output_gradient * parameters_.output_weights[output_index];
+      }
+    }
+    for (size_t unit = 0; unit < k_hidden; unit++) {
+      gradient.hidden_biases[unit] += hidden_gradient[unit];
+    }
+    for (size_t i = 0; i < sample.count; i++) {
+      auto& weights{gradient.hidden_weights[sample.features[side][i]]};
+      for (size_t unit = 0; unit < k_hidden; unit++) {
+        weights[unit] += hidden_gradient[unit];
+      }
+    }
+  }
+  return error * error;
+}
+
+double NnueTrainer::train() {
+  constexpr float k_beta1{0.9F};
+  constexpr float k_beta2{0.999F};
+  constexpr float k_epsilon{1e-8F};
+
+  Parameters momentum;
+  Parameters velocity;
+  int step{};
+  // Applies one Adam step to a group of parameters
+  auto update = [&](std::span<float> values, std::span<const float> gradient,
+                    std::span<float> first, std::span<float> second) {
+    const auto rate{static_cast<float>(
+        config_.learning_rate * std::sqrt(1.0 - std::pow(k_beta2, step)) /
+        (1.0 - std::pow(k_beta1, step)))};
+    for (size_t i = 0; i < values.size(); i++) {
+      first[i] = k_beta1 * first[i] + (1.0F - k_beta1) * gradient[i];
+      second[i] =
+          k_beta2 * second[i] + (1.0F - k_beta2) * gradient[i] * gradient[i];
+      values[i] -= rate * first[i] / (std::sqrt(second[i]) + k_epsilon);
+    }
+  };
+  for (auto* parameters : {&momentum, &velocity}) {
+    for (auto& weights : parameters->hidden_weights) {
+      weights.fill(0.0F);
+    }
+  }
+
+  std::vector<size_t> order(samples_.size());
+  std::iota(order.begin(), order.end(), size_t{});
+  double loss{};
+  for (int epoch = 1; epoch <= config_.epochs; epoch++) {
+    std::shuffle(order.begin(), order.end(), generator_);
+    loss = 0.0;
+    for (size_t begin = 0; begin < order.size();
+         begin += config_.batch_size) {
+      const size_t end{std::min(begin + config_.batch_size, order.size())};
+      Parameters gradient;
+      for (auto& weights : gradient.hidden_weights) {
+        weights.fill(0.0F);
+      }
+      for (size_t i = begin; i < end; i++) {
+        loss += static_cast<double>(accumulate_gradient(
+            samples_[order[i]], results_[order[i]], gradient));
+      }
+
+      step++;
+      for (size_t input = 0; input < k_nnue_inputs; input++) {
+        update(parameters_.hidden_weights[input],
+               gradient.hidden_weights[input], momentum.hidden_weights[input],
+               velocity.hidden_weights[input]);
+      }
+      update(parameters_.hidden_biases, gradient.hidden_biases,
+             momentum.hidden_biases, velocity.hidden_biases);
+      update(parameters_.output_weights, gradient.output_weights,
+             momentum.output_weights, velocity.output_weights);
+      update({&parameters_.output_bias, 1}, {&gradient.output_bias, 1},
+             {&momentum.output_bias, 1}, {&velocity.output_bias, 1});
+      clip_weights();
+    }
+    loss /= static_cast<double>(order.size());
+    LOGF("NNUE", "epoch {} loss {:.6f}", epoch, loss);
+  }
+  return loss;
+}
+
+void NnueTrainer::clip_weights() {
+  for (auto& weights : parameters_.hidden_weights) {
+    for (float& weight : weights) {
+      weight = std::clamp(weight, -k_max_hidden_weight, k_max_hidden_weight);
+    }
+  }
+  for (float& weight : parameters_.output_weights) {
+    weight = std::clamp(weight, -k_max_output_weight, k_max_output_weight);
+  }
+}
+
+NnueParameters NnueTrainer::quantize() const {
+  constexpr double k_activation_max{NnueParameters::k_activation_max};
+  constexpr double k_output_weight_scale{
+      NnueParameters::k_output_weight_scale};
+
+  NnueParameters quantized;
+  for (size_t input = 0; input < k_nnue_inputs; input++) {
+    for (size_t unit = 0; unit < k_hidden; unit++) {
+      quantized.hidden_weights[input][unit] = quantize_value<int16_t>(
+          parameters_.hidden_weights[input][unit], k_activation_max);
+    }
+  }
+  for (size_t unit = 0; unit < k_hidden; unit++) {
+    quantized.hidden_biases[unit] = quantize_value<int16_t>(
+        parameters_.hidden_biases[unit], k_activation_max);
+  }
+  for (size_t i = 0; i < quantized.output_weights.size(); i++) {
+    quantized.output_weights[i] = quantize_value<int8_t>(
+        parameters_.output_weights[i], k_output_weight_scale);
+  }
+  quantized.output_bias = quantize_value<int32_t>(
+      parameters_.output_bias, k_activation_max * k_output_weight_scale);
+  quantized.output_scale =
+      static_cast<int32_t>(std::lround(config_.eval_scale));
+  return quantized;
+}
+
+double NnueTrainer::evaluate(const Board& board) const {
+  std::array<std::array<float, k_hidden>, 2> hidden{};
+  return static_cast<double>(forward(make_sample(board), hidden)) *
+         config_.eval_scale;
+}
@@ -0,0 +1,174 @@
+#include "page_memory.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+PageMemory::PageMemory(PageMemory&& other) noexcept { swap(other); }
+
+PageMemory& PageMemory::operator=(PageMemory&& other) noexcept {
+  if (this != &other) {
+    release();
+    swap(other);
+  }
+  return *this;
+}
+
+void PageMemory::swap(PageMemory& other) noexcept {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  std::swap(is_file_backed_, other.is_file_backed_);
+  std::swap(has_huge_pages_, other.has_huge_pages_);
+#ifdef _WIN32
+  std::swap(file_, other.file_);
+  std::swap(mapping_, other.mapping_);
+#endif
+}
+
+#ifdef _WIN32
+bool PageMemory::allocate(size_t size) {
+  release();
+  // Large pages need the "Lock pages in memory" privilege, so this often
+  // falls back to normal pages
+  void* data{};
+  if (const SIZE_T large_page{GetLargePageMinimum()};
+      large_page != 0 && size % large_page == 0) {
+    data = VirtualAlloc(nullptr, size,
+                        MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                        PAGE_READWRITE);
+    has_huge_pages_ = data != nullptr;
+  }
+  if (data == nullptr) {
+    data = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT,
+                        PAGE_READWRITE);
+  }
+  if (data == nullptr) {
+    return false;
+  }
+  data_ = static_cast<std::byte*>(data);
+  size_ = size;
+  return true;
+}
+
+bool PageMemory::map_file(const std::string& path, size_t size) {
+  release();
+  HANDLE file{CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                          FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                          FILE_ATTRIBUTE_NORMAL, nullptr)};
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  file_ = file;
+  is_file_backed_ = true;
+
+  LARGE_INTEGER end{};
+  end.QuadPart = static_cast<LONGLONG>(size);
+  if (SetFilePointerEx(file, end, nullptr, FILE_BEGIN) == 0 ||
+      SetEndOfFile(file) == 0) {
+    release();
+    return false;
+  }
+  mapping_ = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+  if (mapping_ == nullptr) {
+    release();
+    return false;
+  }
+  data_ = static_cast<std::byte*>(
+      MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size));
+  if (data_ == nullptr) {
+    release();
+    return false;
+  }
+  size_ = size;
+  return true;
+}
+
+void PageMemory::release() {
+  if (is_file_backed_) {
+    if (data_ != nullptr) {
+      UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+      CloseHandle(mapping_);
+    }
+    if (file_ != nullptr) {
+      CloseHandle(file_);
+    }
+  } else if (data_ != nullptr) {
+    VirtualFree(data_, 0, MEM_RELEASE);
+  }
+  data_ = nullptr;
+  mapping_ = nullptr;
+  file_ = nullptr;
+  size_ = 0;
+  is_file_backed_ = false;
+  has_huge_pages_ = false;
+}
+#else
+bool PageMemory::allocate(size_t size) {
+  release();
+  void* data{MAP_FAILED};
+#ifdef MAP_HUGETLB
+  // Explicit huge pages only exist when the administrator reserved them
+  constexpr size_t k_huge_page_size{2 * 1024 * 1024};
+  if (size % k_huge_page_size == 0) {
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    has_huge_pages_ = data != MAP_FAILED;
+  }
+#endif
+  if (data == MAP_FAILED) {
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+#ifdef MADV_HUGEPAGE
+    // Otherwise ask for transparent huge pages
+    madvise(data, size, MADV_HUGEPAGE);
+#endif
+  }
+  data_ = static_cast<std::byte*>(data);
+  size_ = size;
+  return true;
+}
+
+bool PageMemory::map_file(const std::string& path, size_t size) {
+  release();
+  const int file{::open(path.c_str(), O_RDWR | O_CREAT, 0644)};
+  if (file < 0) {
+    return false;
+  }
+  void* data{MAP_FAILED};
+  if (ftruncate(file, static_cast<off_t>(size)) == 0) {
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  }
+  // The mapping stays valid after the descriptor is closed
+  ::close(file);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  data_ = static_cast<std::byte*>(data);
+  size_ = size;
+  is_file_backed_ = true;
+  return true;
+}
+
+void PageMemory::release() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  is_file_backed_ = false;
+  has_huge_pages_ = false;
+}
+#endif
@@ -0,0 +1,346 @@
+#include "position_db.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "game_record.hpp"
+#include "log.hpp"
+
+static_assert(std::endian::native == std::endian::little,
+              "position databases are mapped as little-endian structs");
+static_assert(sizeof(PositionStats) == 24);
+
+namespace {
+constexpr std::string_view k_magic{"CPDB"};
+constexpr uint32_t k_version{1};
+
+struct FileHeader {
+  std::array<char, 4> magic;
+  uint32_t version;
+  uint64_t count;
+};
+static_assert(sizeof(FileHeader) == 16);
+
+bool is_before(const PositionStats& lhs, const PositionStats& rhs) {
+  return lhs.hash != rhs.hash ? lhs.hash < rhs.hash : lhs.move < rhs.move;
+}
+
+bool is_same_key(const PositionStats& lhs, const PositionStats& rhs) {
+  return lhs.hash == rhs.hash && lhs.move == rhs.move;
+}
+
+void accumulate(PositionStats& total, const PositionStats& entry) {
+  total.wins += entry.wins;
+  total.draws += entry.draws;
+  total.losses += entry.losses;
+}
+
+/// <summary>
+/// Sorts the entries and merges duplicate keys in place
+/// </summary>
+void sort_and_aggregate(std::vector<PositionStats>& entries) {
+  std::sort(entries.begin(), entries.end(), is_before);
+  size_t end{};
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (end != 0 && is_same_key(entries[end - 1], entries[i])) {
+      accumulate(entries[end - 1], entries[i]);
+    } else {
+      entries[end++] = entries[i];
+    }
+  }
+  entries.resize(end);
+}
+
+bool write_entries(std::ofstream& file,
+                   std::span<const PositionStats> entries) {
+  file.write(reinterpret_cast<const char*>(entries.data()),
+             static_cast<std::streamsize>(entries.size_bytes()));
+  return file.good();
+}
+
+/// <summary>
+/// Replays the games assigned to one thread and spills sorted runs
+/// </summary>
+class RunWriter {
+ public:
+  RunWriter(const PositionDbBuildConfig& config,
+            std::atomic<size_t>& next_run, std::vector<std::string>& runs,
+            std::mutex& runs_mutex)
+      : config_{config},
+        next_run_{next_run},
+        runs_{runs},
+        runs_mutex_{runs_mutex} {
+    entries_.reserve(config.run_size);
+  }
+
+  void add_game(const GameView& game) {
+    const GameResult result{game.get_result()};
+    if (result == GameResult::None) {
+      return;
+    }
+    if (!game.load_start(board_)) {
+      return;
+    }
+
+    const size_t plies{std::min(game.get_move_count(),
+                                static_cast<size_t>(config_.max_plies))};
+    for (size_t ply = 0; ply < plies; ply++) {
+      const Move move{game.get_move(ply)};
+      if (!is_legal_move(board_, move)) {
+        break;
+      }
+      PositionStats& entry{entries_.emplace_back()};
+      entry.hash = board_.get_hash();
+      entry.move = pack_move(move);
+      if (result == GameResult::Draw) {
+        entry.draws = 1;
+      } else if ((result == GameResult::WhiteWins) ==
+                 (board_.get_turn() == PieceColor::White)) {
+        entry.wins = 1;
+      } else {
+        entry.losses = 1;
+      }
+      board_.move(move);
+
+      if (entries_.size() >= config_.run_size) {
+        flush();
+      }
+    }
+  }
+
+  bool flush() {
+    if (entries_.empty()) {
+      return true;
+    }
+    sort_and_aggregate(entries_);
+    const std::string path{
+        std::format("{}.run{}", config_.output_path, next_run_++)};
+    std::ofstream file{path, std::ios::binary};
+    const bool is_written{write_entries(file, entries_)};
+    entries_.clear();
+    {
+      std::lock_guard<std::mutex> lock(runs_mutex_);
+      runs_.push_back(path);
+    }
+    if (!is_written) {
+      LOGF("POSITIONDB", "Failed to write {}", path);
+    }
+    return is_written;
+  }
+
+ private:
+  const PositionDbBuildConfig& config_;
+  std::atomic<size_t>& next_run_;
+  std::vector<std::string>& runs_;
+  std::mutex& runs_mutex_;
+  std::vector<PositionStats> entries_;
+  Board board_;
+};
+
+/// <summary>
+/// Buffered sequential reader over one run file
+/// </summary>
+class RunReader {
+  static constexpr size_t k_buffer_size{4096};
+
+ public:
+  explicit RunReader(const std::string& path)
+      : file_{path, std::ios::binary} {
+    buffer_.resize(k_buffer_size);
+  }
+
+  bool next(PositionStats& entry) {
+    if (position_ == size_) {
+      file_.read(reinterpret_cast<char*>(buffer_.data()),
+                 static_cast<std::streamsize>(k_buffer_size *
+                                              sizeof(PositionStats)));
+      size_ = static_cast<size_t>(file_.gcount()) / sizeof(PositionStats);
+      position_ = 0;
+      if (size_ == 0) {
+        return false;
+      }
+    }
+    entry = buffer_[position_++];
+    return true;
+  }
+
+ private:
+  std::ifstream file_;
+  std::vector<PositionStats> buffer_;
+  size_t position_{};
+  size_t size_{};
+};
+
+bool merge_runs(const std::vector<std::string>& runs,
+                const std::string& output_path, uint64_t& count) {
+  std::ofstream output{output_path, std::ios::binary | std::ios::trunc};
+  FileHeader header{};
+  std::memcpy(header.magic.data(), k_magic.data(), k_magic.size());
+  header.version = k_version;
+  output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  std::vector<RunReader> readers;
+  readers.reserve(runs.size());
+  for (const std::string& run : runs) {
+    readers.emplace_back(run);
+  }
+
+  using HeapItem = std::pair<PositionStats, size_t>;
+  auto is_after = [](const HeapItem& lhs, const HeapItem& rhs) {
+    return is_before(rhs.first, lhs.first);
+  };
+  std::priority_queue<HeapItem, std::vector<HeapItem>, decltype(is_after)>
+      heap{is_after};
+  for (size_t i = 0; i < readers.size(); i++) {
+    if (PositionStats entry{}; readers[i].next(entry)) {
+      heap.emplace(entry, i);
+    }
+  }
+
+  std::vector<PositionStats> pending;
+  pending.reserve(4096);
+  count = 0;
+  while (!heap.empty()) {
+    const auto [entry, run]{heap.top()};
+    heap.pop();
+    if (!pending.empty() && is_same_key(pending.back(), entry)) {
+      accumulate(pending.back(), entry);
+    } else {
+      if (pending.size() == pending.capacity()) {
+        write_entries(output, pending);
+        count += pending.size();
+        pending.clear();
+      }
+      pending.push_back(entry);
+    }
+    if (PositionStats next{}; readers[run].next(next)) {
+      heap.emplace(next, run);
+    }
+  }
+  write_entries(output, pending);
+  count += pending.size();
+
+  header.count = count;
+  output.seekp(0);
+  output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  return output.good();
+}
+}  // namespace
+
+double PositionStats::get_score() const {
+  const uint32_t count{get_count()};
+  return count != 0 ? (wins + 0.5 * draws) / count : 0.0;
+}
+
+Move PositionStats::get_move() const { return unpack_move(move); }
+
+bool build_position_db(const PositionDbBuildConfig& config) {
+  std::vector<GameRecordReader> readers(config.record_paths.size());
+  size_t game_count{};
+  for (size_t i = 0; i < readers.size(); i++) {
+    if (!readers[i].open(config.record_paths[i])) {
+      return false;
+    }
+    game_count += readers[i].get_size();
+  }
+
+  std::atomic<size_t> next_run{};
+  std::vector<std::string> runs;
+  std::mutex runs_mutex;
+  std::atomic<bool> is_failed{};
+  {
+    const size_t thread_count{std::max<size_t>(config.threads, 1)};
+    std::vector<std::jthread> threads;
+    for (size_t thread = 0; thread < thread_count; thread++) {
+      threads.emplace_back([&, thread] {
+        RunWriter writer{config, next_run, runs, runs_mutex};
+        // Games are dealt out round-robin over the concatenated files
+        size_t index{};
+        for (const GameRecordReader& reader : readers) {
+          for (size_t game = 0; game < reader.get_size(); game++, index++) {
+            if (index % thread_count == thread) {
+              writer.add_game(reader.get_game(game));
+            }
+          }
+        }
+        if (!writer.flush()) {
+          is_failed = true;
+        }
+      });
+    }
+  }
+
+  uint64_t count{};
+  const bool is_merged{!is_failed &&
+                       merge_runs(runs, config.output_path, count)};
+  for (const std::string& run : runs) {
+    std::error_code error;
+    std::filesystem::remove(run, error);
+  }
+  if (!is_merged) {
+    LOGF("POSITIONDB", "Failed to build {}", config.output_path);
+    return false;
+  }
+  LOGF("POSITIONDB", "{} games, {} runs, {} entries written to {}",
+       game_count, runs.size(), count, config.output_path);
+  return true;
+}
+
+bool PositionDb::open(const std::string& path) {
+  entries_ = {};
+  if (!file_.open(path)) {
+    LOGF("POSITIONDB", "Failed to open {}", path);
+    return false;
+  }
+
+  const std::span<const std::byte> data{file_.get_data()};
+  FileHeader header{};
+  if (data.size() >= sizeof(header)) {
+    std::memcpy(&header, data.data(), sizeof(header));
+  }
+  if (std::string_view{header.magic.data(), header.magic.size()} != k_magic ||
+      header.version != k_version ||
+      header.count > (data.size() - sizeof(header)) / sizeof(PositionStats)) {
+    LOGF("POSITIONDB", "{} is not a version {} position database", path,
+         k_version);
+    file_.close();
+    return false;
+  }
+  entries_ = {reinterpret_cast<const PositionStats*>(data.data() +
+                                                      sizeof(header)),
+              header.count};
+  return true;
+}
+
+std::span<const PositionStats> PositionDb::find(uint64_t hash) const {
+  const auto [first, last]{
+      std::ranges::equal_range(entries_, hash, {}, &PositionStats::hash)};
+  return {first, last};
+}
+
+std::optional<Move> PositionDb::pick_move(uint64_t hash,
+                                          uint32_t min_games) const {
+  const PositionStats* best{};
+  for (const PositionStats& entry : find(hash)) {
+    if (entry.get_count() < min_games) {
+      continue;
+    }
+    if (best == nullptr || entry.get_score() > best->get_score() ||
+        (entry.get_score() == best->get_score() &&
+         entry.get_count() > best->get_count())) {
+      best = &entry;
+    }
+  }
+  if (best == nullptr) {
+    return std::nullopt;
+  }
+  return best->get_move();
+}
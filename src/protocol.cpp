@@ -0,0 +1,238 @@
+#include "protocol.hpp"
+
+#include <charconv>
+#include <format>
+
+std::vector<std::string_view> split_words(std::string_view line) {
+  std::vector<std::string_view> words;
+  size_t begin{line.find_first_not_of(" \t\r")};
+  while (begin != std::string_view::npos) {
+    const size_t end{line.find_first_of(" \t\r", begin)};
+    words.push_back(line.substr(begin, end - begin));
+    begin = line.find_first_not_of(" \t\r", end);
+  }
+  return words;
+}
+
+std::optional<int> parse_int(std::string_view text) {
+  int value{};
+  const auto [ptr, error]{
+      std::from_chars(text.data(), text.data() + text.size(), value)};
+  if (error != std::errc{} || ptr != text.data() + text.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+std::optional<Difficulty> parse_difficulty(std::string_view name) {
+  for (size_t i = 0; i < k_difficulty_presets.size(); i++) {
+    if (k_difficulty_presets[i].name == name) {
+      return static_cast<Difficulty>(i);
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<std::string> set_position(Board& board, ProtocolArgs args) {
+  // Built on a copy, so that an error leaves the board as it was. The copy
+  // keeps the variant and repetition rule
+  Board position;
+  position = board;
+  size_t index{1};
+  if (!args.empty() && args[0] == "startpos") {
+    position.load_fen();
+  } else if (!args.empty() && args[0] == "fen") {
+    std::string fen;
+    for (; index < args.size() && args[index] != "moves"; index++) {
+      if (!fen.empty()) {
+        fen += ' ';
+      }
+      fen += args[index];
+    }
+    if (!position.load_fen(fen)) {
+      return "bad fen";
+    }
+  } else {
+    return "expected startpos or fen";
+  }
+
+  if (index < args.size() && args[index] == "moves") {
+    for (index++; index < args.size(); index++) {
+      const std::optional<Move> move{parse_move(args[index])};
+      Moves legal_moves;
+      if (move) {
+        position.generate_legal_moves(legal_moves, move->tile);
+      }
+      const auto end{legal_moves.data.begin() + legal_moves.size};
+      if (!move || std::find(legal_moves.data.begin(), end, *move) == end) {
+        return std::format("illegal move {}", args[index]);
+      }
+      position.make_move(*move);
+    }
+  }
+  board = position;
+  return std::nullopt;
+}
+
+std::optional<std::string> parse_limits(ProtocolArgs args,
+                                        SearchLimits& limits) {
+  for (size_t i = 0; i + 1 < args.size(); i += 2) {
+    const std::optional<int> value{parse_int(args[i + 1])};
+    if (!value || *value < 0) {
+      return std::format("bad value for {}", args[i]);
+    }
+    constexpr size_t k_white{get_color_index(PieceColor::White)};
+    constexpr size_t k_black{get_color_index(PieceColor::Black)};
+    const std::chrono::milliseconds ms{*value};
+    if (args[i] == "depth") {
+      limits.depth = *value;
+    } else if (args[i] == "nodes") {
+      limits.nodes = static_cast<uint64_t>(*value);
+    } else if (args[i] == "movetime") {
+      limits.movetime = ms;
+    } else if (args[i] == "multipv") {
+      limits.multi_pv = std::max(*value, 1);
+    } else if (args[i] == "wtime") {
+      limits.clock[k_white] = ms;
+    } else if (args[i] == "btime") {
+      limits.clock[k_black] = ms;
+    } else if (args[i] == "winc") {
+      limits.increment[k_white] = ms;
+    } else if (args[i] == "binc") {
+      limits.increment[k_black] = ms;
+    } else if (args[i] == "movestogo") {
+      limits.moves_to_go = *value;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<std::string> set_search_option(SearchOptions& options,
+                                             std::string_view name,
+                                             std::string_view value) {
+  auto set_bool = [value](bool& option) {
+    if (value == "on" || value == "true" || value == "1") {
+      option = true;
+    } else if (value == "off" || value == "false" || value == "0") {
+      option = false;
+    } else {
+      return false;
+    }
+    return true;
+  };
+  auto set_int = [value](int& option) {
+    const std::optional<int> parsed{parse_int(value)};
+    if (!parsed || *parsed < 0) {
+      return false;
+    }
+    option = *parsed;
+    return true;
+  };
+  auto set_double = [value](double& option) {
+    double parsed{};
+    const auto [ptr, error]{
+        std::from_chars(value.data(), value.data() + value.size(), parsed)};
+    if (error != std::errc{} || ptr != value.data() + value.size()) {
+      return false;
+    }
+    option = parsed;
+    return true;
+  };
+
+  bool is_valid{};
+  if (name == "depth") {
+    is_valid = set_int(options.max_depth);
+  } else if (name == "nodes") {
+    int max_nodes{};
+    is_valid = set_int(max_nodes);
+    options.max_nodes = static_cast<uint64_t>(max_nodes);
+  } else if (name == "eval_noise") {
+    is_valid = set_int(options.eval_noise);
+  } else if (name == "difficulty") {
+    const std::optional<Difficulty> difficulty{parse_difficulty(value)};
+    if (difficulty) {
+      apply_difficulty(options, *difficulty);
+    }
+    is_valid = difficulty.has_value();
+  } else if (name == "hash") {
+    int size_mb{};
+    is_valid = set_int(size_mb) && size_mb > 0;
+    options.hash_size_mb = static_cast<size_t>(size_mb);
+  } else if (name == "hash_file") {
+    options.hash_path = value;
+    is_valid = true;
+  } else if (name == "log") {
+    is_valid = set_bool(options.log_search);
+  } else if (name == "pvs") {
+    is_valid = set_bool(options.use_pvs);
+  } else if (name == "aspiration") {
+    is_valid = set_bool(options.use_aspiration);
+  } else if (name == "lmr") {
+    is_valid = set_bool(options.use_lmr);
+  } else if (name == "aspiration_min_depth") {
+    is_valid = set_int(options.aspiration_min_depth);
+  } else if (name == "aspiration_window") {
+    is_valid = set_int(options.aspiration_window);
+  } else if (name == "lmr_min_depth") {
+    is_valid = set_int(options.lmr_min_depth);
+  } else if (name == "lmr_min_move") {
+    is_valid = set_int(options.lmr_min_move);
+  } else if (name == "lmr_base") {
+    is_valid = set_double(options.lmr_base);
+  } else if (name == "lmr_divisor") {
+    is_valid = set_double(options.lmr_divisor) && options.lmr_divisor > 0.0;
+  } else if (name == "book") {
+    options.book_path = value;
+    is_valid = true;
+  } else if (name == "book_min_games") {
+    is_valid = set_int(options.book_min_games);
+  } else if (name == "nnue") {
+    options.nnue_path = value;
+    is_valid = true;
+  } else if (name == "move_overhead") {
+    is_valid = set_int(options.move_overhead_ms);
+  } else if (name == "solver") {
+    is_valid = set_bool(options.use_solver);
+  } else if (name == "solver_max_pawns") {
+    is_valid = set_int(options.solver_max_pawns);
+  } else if (name == "solver_nodes") {
+    is_valid = set_int(options.solver_max_nodes);
+  } else {
+    return std::format("unknown option {}", name);
+  }
+
+  if (!is_valid) {
+    return std::format("bad value {} for {}", value, name);
+  }
+  return std::nullopt;
+}
+
+bool is_game_over(Board& board) {
+  if (board.count_in_target(PieceColor::White) == 9 ||
+      board.count_in_target(PieceColor::Black) == 9 ||
+      board.is_repetition_draw()) {
+    return true;
+  }
+  return !board.has_legal_moves();
+}
+
+std::string format_info(const SearchResult& result) {
+  if (result.is_book_move) {
+    return "info book";
+  }
+  const SearchStats& stats{result.stats};
+  std::string info;
+  for (size_t i = 0; i < result.lines.size(); i++) {
+    const PvLine& line{result.lines[i]};
+    info += std::format(
+        "{}info depth {} seldepth {} multipv {} score {} nodes {} nps {:.0f} "
+        "time {:.0f} hashhit {:.3f} pv",
+        i == 0 ? "" : "\n", stats.depth, stats.seldepth, i + 1, line.score,
+        stats.nodes, stats.get_nps(), stats.elapsed_ms,
+        stats.get_hash_hit_rate());
+    for (const Move move : line.moves) {
+      info += ' ' + move_to_string(move);
+    }
+  }
+  return info;
+}
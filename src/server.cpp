@@ -0,0 +1,91 @@
+#include "server.hpp"
+
+#include <array>
+
+#ifdef _WIN32
+#define poll WSAPoll
+using PollSize = ULONG;
+#else
+#include <poll.h>
+using PollSize = nfds_t;
+#endif
+
+#include "log.hpp"
+
+Server::Server(EngineService& service, Socket listener)
+    : service_{service}, listener_{std::move(listener)} {}
+
+void Server::run() {
+  std::vector<pollfd> poll_fds;
+  while (true) {
+    poll_fds.clear();
+    poll_fds.push_back({listener_.get_handle(), POLLIN, 0});
+    for (const auto& connection : connections_) {
+      poll_fds.push_back({connection->socket.get_handle(), POLLIN, 0});
+    }
+
+    if (poll(poll_fds.data(), static_cast<PollSize>(poll_fds.size()), -1) <
+        0) {
+      LOG("SERVER", "poll failed");
+      return;
+    }
+
+    // Connections first: accepting would shift the indices
+    for (size_t i = connections_.size(); i > 0; i--) {
+      if (poll_fds[i].revents == 0) {
+        continue;
+      }
+      if (!read_connection(connections_[i - 1])) {
+        close_connection(*connections_[i - 1]);
+        connections_.erase(connections_.begin() +
+                           static_cast<std::ptrdiff_t>(i - 1));
+      }
+    }
+
+    if ((poll_fds[0].revents & POLLIN) != 0) {
+      accept_connection();
+    }
+  }
+}
+
+void Server::accept_connection() {
+  std::optional<Socket> socket{listener_.accept()};
+  if (!socket) {
+    return;
+  }
+  connections_.push_back(
+      std::make_shared<Connection>(std::move(*socket), next_connection_id_++));
+  LOGF("SERVER", "connection opened, {} active", connections_.size());
+}
+
+bool Server::read_connection(const std::shared_ptr<Connection>& connection) {
+  std::array<char, 4096> buffer{};
+  const int size{connection->socket.receive(buffer.data(),
+                                            static_cast<int>(buffer.size()))};
+  if (size <= 0) {
+    LOGF("SERVER", "connection closed, {} active", connections_.size() - 1);
+    return false;
+  }
+  connection->lines.append({buffer.data(), static_cast<size_t>(size)});
+
+  while (std::optional<std::string> line = connection->lines.next_line()) {
+    // The connection is kept alive by the reply until it is sent
+    service_.execute(
+        *line,
+        [connection](const std::string& reply) {
+          std::lock_guard<std::mutex> lock(connection->send_mutex);
+          if (connection->is_open) {
+            connection->socket.send_all(reply + '\n');
+          }
+        },
+        connection->id);
+  }
+  return true;
+}
+
+void Server::close_connection(Connection& connection) {
+  service_.close_games(connection.id);
+  std::lock_guard<std::mutex> lock(connection.send_mutex);
+  connection.is_open = false;
+  connection.socket.close();
+}
@@ -0,0 +1,66 @@
+#include "simd.hpp"
+
+#include <array>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef CORNERPAWNS_X86
+namespace {
+SimdLevel detect_simd_level() {
+#ifdef _MSC_VER
+  std::array<int, 4> info{};
+  __cpuid(info.data(), 0);
+  if (info[0] < 7) {
+    return SimdLevel::Scalar;
+  }
+  __cpuid(info.data(), 1);
+  // The OS must save the AVX registers on context switches
+  const bool has_osxsave{(info[2] & (1 << 27)) != 0};
+  if (!has_osxsave) {
+    return SimdLevel::Scalar;
+  }
+  const unsigned long long xcr0{_xgetbv(0)};
+  __cpuidex(info.data(), 7, 0);
+  if ((info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6) {
+    return SimdLevel::Avx512;
+  }
+  if ((info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6) {
+    return SimdLevel::Avx2;
+  }
+  return SimdLevel::Scalar;
+#else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SimdLevel::Avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::Avx2;
+  }
+  return SimdLevel::Scalar;
+#endif
+}
+}  // namespace
+#endif
+
+std::string_view to_string(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::Scalar:
+      return "scalar";
+    case SimdLevel::Avx2:
+      return "avx2";
+    case SimdLevel::Avx512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+SimdLevel get_simd_level() {
+#ifdef CORNERPAWNS_X86
+  static const SimdLevel level{detect_simd_level()};
+  return level;
+#else
+  return SimdLevel::Scalar;
+#endif
+}
@@ -0,0 +1,157 @@
+#include "socket.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+using IoSize = int;
+#else
+using IoSize = size_t;
+#endif
+
+// A peer that hung up must not kill the whole process with SIGPIPE
+#ifdef MSG_NOSIGNAL
+constexpr int k_send_flags{MSG_NOSIGNAL};
+#else
+constexpr int k_send_flags{};
+#endif
+
+void close_native(NativeSocket handle) {
+#ifdef _WIN32
+  closesocket(handle);
+#else
+  ::close(handle);
+#endif
+}
+
+void set_no_delay(NativeSocket handle) {
+  const int enable{1};
+  setsockopt(handle, IPPROTO_TCP, TCP_NODELAY,
+             reinterpret_cast<const char*>(&enable), sizeof(enable));
+}
+}  // namespace
+
+Socket& Socket::operator=(Socket&& other) noexcept {
+  if (this != &other) {
+    close();
+    handle_ = other.release();
+  }
+  return *this;
+}
+
+bool Socket::init() {
+#ifdef _WIN32
+  static const bool initialized{[] {
+    WSADATA data{};
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+  }()};
+  return initialized;
+#else
+  return true;
+#endif
+}
+
+std::optional<Socket> Socket::listen(uint16_t port) {
+  Socket socket{::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)};
+  if (!socket.is_valid()) {
+    return std::nullopt;
+  }
+  const int enable{1};
+  setsockopt(socket.handle_, SOL_SOCKET, SO_REUSEADDR,
+             reinterpret_cast<const char*>(&enable), sizeof(enable));
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::bind(socket.handle_, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(socket.handle_, SOMAXCONN) != 0) {
+    return std::nullopt;
+  }
+  return socket;
+}
+
+std::optional<Socket> Socket::connect(const std::string& host, uint16_t port) {
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result{};
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints,
+                  &result) != 0) {
+    return std::nullopt;
+  }
+
+  Socket socket{::socket(result->ai_family, result->ai_socktype,
+                         result->ai_protocol)};
+  const bool connected{
+      socket.is_valid() &&
+      ::connect(socket.handle_, result->ai_addr, result->ai_addrlen) == 0};
+  freeaddrinfo(result);
+  if (!connected) {
+    return std::nullopt;
+  }
+  set_no_delay(socket.handle_);
+  return socket;
+}
+
+std::optional<Socket> Socket::accept() const {
+  Socket client{::accept(handle_, nullptr, nullptr)};
+  if (!client.is_valid()) {
+    return std::nullopt;
+  }
+  set_no_delay(client.handle_);
+  return client;
+}
+
+bool Socket::send_all(std::string_view data) const {
+  while (!data.empty()) {
+    const auto sent{
+        ::send(handle_, data.data(), static_cast<IoSize>(data.size()),
+                k_send_flags)};
+    if (sent <= 0) {
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(sent));
+  }
+  return true;
+}
+
+int Socket::receive(char* buffer, int size) const {
+  return static_cast<int>(
+      ::recv(handle_, buffer, static_cast<IoSize>(size), 0));
+}
+
+void Socket::close() {
+  if (is_valid()) {
+    close_native(release());
+  }
+}
+
+NativeSocket Socket::release() {
+  return std::exchange(handle_, k_invalid_socket);
+}
+
+std::optional<std::string> LineBuffer::next_line() {
+  const size_t end{buffer_.find('\n')};
+  if (end == std::string::npos) {
+    return std::nullopt;
+  }
+  std::string line{buffer_.substr(0, end)};
+  buffer_.erase(0, end + 1);
+  if (!line.empty() && line.back() == '\r') {
+    line.pop_back();
+  }
+  return line;
+}
@@ -0,0 +1,181 @@
+#include "solver.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+// Keeps the tables of the two possible attackers apart
+constexpr uint64_t k_black_attacker_key{0x9E3779B97F4A7C15ULL};
+
+uint32_t add_saturated(uint32_t sum, uint32_t value, uint32_t limit) {
+  return static_cast<uint32_t>(
+      std::min<uint64_t>(uint64_t{sum} + value, limit));
+}
+}  // namespace
+
+int count_pawns_outside_targets(const Board& board) {
+  return 18 - board.count_in_target(PieceColor::White) -
+         board.count_in_target(PieceColor::Black);
+}
+
+void ProofSolver::clear() {
+  std::fill(entries_.begin(), entries_.end(), Entry{});
+}
+
+SolverResult ProofSolver::solve(const Board& board, uint64_t max_nodes,
+                                const std::function<bool()>& should_stop) {
+  if (entries_.empty()) {
+    const size_t count{
+        std::bit_floor(hash_size_mb_ * 1024 * 1024 / sizeof(Entry))};
+    entries_.assign(count, {});
+    mask_ = count - 1;
+    frames_.resize(k_max_ply);
+  }
+  board_ = board;
+  board_.set_nnue(nullptr);
+  // A single earlier occurrence already draws
+  board_.set_repetition_limit(2);
+  attacker_ = board_.get_turn();
+  nodes_ = 0;
+  max_nodes_ = max_nodes;
+  should_stop_ = should_stop ? &should_stop : nullptr;
+  aborted_ = false;
+
+  const Numbers numbers{search({k_infinity, k_infinity}, 0)};
+  SolverResult result;
+  result.nodes = nodes_;
+  if (aborted_) {
+    return result;
+  }
+  if (numbers.proof != 0) {
+    result.outcome = SolverOutcome::NoWin;
+    return result;
+  }
+
+  // The root's frame still holds the numbers of its children: the table
+  // entry of the proven child may have been replaced since
+  const Frame& root{frames_[0]};
+  for (int i = 0; i < root.moves.size; i++) {
+    if (root.children[i].proof == 0) {
+      result.outcome = SolverOutcome::Win;
+      result.best_move = root.moves.data[i];
+      break;
+    }
+  }
+  return result;
+}
+
+ProofSolver::Numbers ProofSolver::search(Numbers thresholds, int ply) {
+  nodes_++;
+  // Nodes are expensive enough that a few hundred of them take about a
+  // millisecond, which is as late as a tight clock may notice the stop
+  if (nodes_ >= max_nodes_ ||
+      ((nodes_ & 255U) == 0 && should_stop_ != nullptr && (*should_stop_)())) {
+    aborted_ = true;
+  }
+  if (aborted_) {
+    return {};
+  }
+
+  // Attacker nodes need one proven child, defender nodes all of them
+  const bool is_attacker{board_.get_turn() == attacker_};
+  if (ply >= k_max_ply) {
+    // Too deep to prove anything, but only for this path: not stored
+    return k_disproven;
+  }
+  Frame& frame{frames_[ply]};
+  Moves& moves{frame.moves};
+  std::array<Numbers, k_max_moves>& children{frame.children};
+  moves.size = 0;
+  board_.generate_all_legal_moves(moves);
+  if (moves.size == 0) {
+    // Whoever cannot move has lost
+    const Numbers numbers{is_attacker ? k_disproven : k_proven};
+    store(numbers);
+    return numbers;
+  }
+
+  for (int i = 0; i < moves.size; i++) {
+    children[i] = evaluate_child(moves.data[i]);
+  }
+
+  while (true) {
+    // The child to expand minimizes the number that decides this node;
+    // the runner-up bounds how long it stays the best choice
+    uint32_t sum{};
+    int best{};
+    uint32_t best_value{k_infinity};
+    uint32_t second_value{k_infinity};
+    for (int i = 0; i < moves.size; i++) {
+      const Numbers child{children[i]};
+      const uint32_t value{is_attacker ? child.proof : child.disproof};
+      const uint32_t other{is_attacker ? child.disproof : child.proof};
+      sum = add_saturated(sum, other, k_infinity);
+      if (value < best_value) {
+        second_value = best_value;
+        best_value = value;
+        best = i;
+      } else if (value < second_value) {
+        second_value = value;
+      }
+    }
+    const Numbers numbers{
+        is_attacker ? Numbers{best_value, sum} : Numbers{sum, best_value}};
+
+    if (numbers.proof >= thresholds.proof ||
+        numbers.disproof >= thresholds.disproof) {
+      store(numbers);
+      return numbers;
+    }
+
+    const Numbers best_child{children[best]};
+    Numbers child_thresholds;
+    if (is_attacker) {
+      child_thresholds = {
+          std::min(thresholds.proof, second_value + 1),
+          thresholds.disproof - numbers.disproof + best_child.disproof};
+    } else {
+      child_thresholds = {
+          thresholds.proof - numbers.proof + best_child.proof,
+          std::min(thresholds.disproof, second_value + 1)};
+    }
+
+    board_.move(moves.data[best]);
+    children[best] = search(child_thresholds, ply + 1);
+    board_.undo();
+    if (aborted_) {
+      return {};
+    }
+  }
+}
+
+ProofSolver::Numbers ProofSolver::evaluate_child(Move move) {
+  const PieceColor mover{board_.get_turn()};
+  board_.move(move);
+  Numbers numbers;
+  if (board_.count_in_target(mover) == 9) {
+    numbers = mover == attacker_ ? k_proven : k_disproven;
+  } else if (board_.is_repetition_draw()) {
+    numbers = k_disproven;
+  } else {
+    numbers = lookup();
+  }
+  board_.undo();
+  return numbers;
+}
+
+uint64_t ProofSolver::get_key() const {
+  return board_.get_hash() ^
+         (attacker_ == PieceColor::Black ? k_black_attacker_key : 0);
+}
+
+ProofSolver::Numbers ProofSolver::lookup() const {
+  const uint64_t key{get_key()};
+  const Entry& entry{entries_[key & mask_]};
+  return entry.key == key ? entry.numbers : Numbers{};
+}
+
+void ProofSolver::store(Numbers numbers) {
+  const uint64_t key{get_key()};
+  entries_[key & mask_] = {key, numbers};
+}
@@ -0,0 +1,82 @@
+#include "thread_pool.hpp"
+
+namespace {
+// Index of the pool worker running on this thread, npos for outsiders
+thread_local size_t t_worker_index{static_cast<size_t>(-1)};
+}  // namespace
+
+ThreadPool::ThreadPool(size_t thread_count) {
+  thread_count = std::max<size_t>(thread_count, 1);
+  for (size_t i = 0; i < thread_count; i++) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < thread_count; i++) {
+    threads_.emplace_back(std::bind_front(&ThreadPool::run, this), i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  for (std::jthread& thread : threads_) {
+    thread.request_stop();
+  }
+  wake_condition_.notify_all();
+  threads_.clear();
+}
+
+void ThreadPool::submit(Task task) {
+  size_t index{t_worker_index};
+  if (index >= queues_.size()) {
+    index = next_queue_.fetch_add(1, std::memory_order_relaxed) %
+            queues_.size();
+  }
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    pending_++;
+  }
+  wake_condition_.notify_one();
+}
+
+void ThreadPool::run(const std::stop_token& stop_token, size_t index) {
+  t_worker_index = index;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      if (!wake_condition_.wait(lock, stop_token,
+                                [this] { return pending_ != 0; })) {
+        break;
+      }
+    }
+
+    Task task;
+    if (try_pop(index, task)) {
+      pending_--;
+      task();
+    }
+  }
+}
+
+bool ThreadPool::try_pop(size_t index, Task& task) {
+  {
+    Queue& own{*queues_[index]};
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.front());
+      own.tasks.pop_front();
+      return true;
+    }
+  }
+  for (size_t i = 1; i < queues_.size(); i++) {
+    Queue& victim{*queues_[(index + i) % queues_.size()]};
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.back());
+      victim.tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,284 @@
+#include "tournament.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <format>
+#include <random>
+#include <thread>
+
+#include "protocol.hpp"
+
+namespace {
+double elo_to_score(double elo) {
+  return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double score_to_elo(double score) {
+  score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+  return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+// Returns the FEN of a "fen <fen> [moves ...]" position, empty for startpos
+std::string get_start_fen(std::span<const std::string_view> words) {
+  std::string fen;
+  if (words.empty() || words[0] != "fen") {
+    return fen;
+  }
+  for (const std::string_view word : words.subspan(1)) {
+    if (word == "moves") {
+      break;
+    }
+    if (!fen.empty()) {
+      fen += ' ';
+    }
+    fen += word;
+  }
+  return fen;
+}
+}  // namespace
+
+double SprtConfig::get_lower_bound() const {
+  return std::log(beta / (1.0 - alpha));
+}
+
+double SprtConfig::get_upper_bound() const {
+  return std::log((1.0 - beta) / alpha);
+}
+
+double TournamentResult::get_score() const {
+  const int games{get_games()};
+  return games != 0 ? (wins + 0.5 * draws) / games : 0.5;
+}
+
+double TournamentResult::get_elo() const { return score_to_elo(get_score()); }
+
+double TournamentResult::get_elo_error() const {
+  const int games{get_games()};
+  if (games == 0) {
+    return 0.0;
+  }
+  const double score{get_score()};
+  const double variance{(wins * std::pow(1.0 - score, 2) +
+                         draws * std::pow(0.5 - score, 2) +
+                         losses * std::pow(score, 2)) /
+                        games};
+  const double margin{1.959964 * std::sqrt(variance / games)};
+  return (score_to_elo(score + margin) - score_to_elo(score - margin)) / 2.0;
+}
+
+double TournamentResult::get_llr(const SprtConfig& sprt) const {
+  // Normal approximation of the trinomial GSPRT
+  const int games{get_games()};
+  if (games == 0) {
+    return 0.0;
+  }
+  const double score{get_score()};
+  const double variance{(wins * std::pow(1.0 - score, 2) +
+                         draws * std::pow(0.5 - score, 2) +
+                         losses * std::pow(score, 2)) /
+                        games};
+  // Only when every game ended the same way, e.g. all draws
+  if (variance <= 0.0) {
+    return 0.0;
+  }
+  const double score0{elo_to_score(sprt.elo0)};
+  const double score1{elo_to_score(sprt.elo1)};
+  return games * (score1 - score0) * (2.0 * score - score0 - score1) /
+         (2.0 * variance);
+}
+
+double TournamentResult::get_nps() const {
+  return search_ms > 0.0 ? static_cast<double>(nodes) * 1000.0 / search_ms
+                         : 0.0;
+}
+
+Tournament::Tournament(TournamentConfig config) : config_{std::move(config)} {
+  if (config_.openings.empty()) {
+    config_.openings.emplace_back("startpos");
+  }
+  config_.engine_a.log_search = false;
+  config_.engine_b.log_search = false;
+}
+
+std::optional<TournamentResult> Tournament::run() {
+  // A game that cannot start must not be scored
+  bool are_openings_valid{true};
+  for (const std::string& opening : config_.openings) {
+    Board board;
+    if (const auto error = set_opening(board, opening)) {
+      LOGF("SELFPLAY", "bad opening {}: {}", opening, *error);
+      are_openings_valid = false;
+    }
+  }
+  if (!are_openings_valid) {
+    return std::nullopt;
+  }
+
+  if (!config_.record_path.empty()) {
+    records_.open(config_.record_path);
+  }
+
+  const auto start{std::chrono::steady_clock::now()};
+  {
+    std::vector<std::jthread> workers;
+    for (size_t i = 0; i < std::max<size_t>(config_.threads, 1); i++) {
+      workers.emplace_back(&Tournament::run_worker, this);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(result_mutex_);
+  result_.wall_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  records_.flush();
+  return result_;
+}
+
+std::vector<std::string> Tournament::generate_openings(int count, int plies,
+                                                       uint64_t seed) {
+  std::mt19937_64 generator{seed};
+  std::vector<std::string> openings;
+  Board board;
+  while (static_cast<int>(openings.size()) < count) {
+    board.load_fen();
+    std::string opening{"startpos moves"};
+    for (int ply = 0; ply < plies; ply++) {
+      Moves moves;
+      board.generate_all_legal_moves(moves);
+      std::uniform_int_distribution<int> distribution{0, moves.size - 1};
+      const Move move{moves.data[distribution(generator)]};
+      board.make_move(move);
+      opening += ' ' + move_to_string(move);
+    }
+    if (!board.is_in_checkmate()) {
+      openings.push_back(std::move(opening));
+    }
+  }
+  return openings;
+}
+
+std::optional<std::string> Tournament::set_opening(
+    Board& board, const std::string& opening) const {
+  board.set_repetition_limit(config_.repetition_limit);
+  board.set_jumps(config_.jumps);
+  const std::vector<std::string_view> words{split_words(opening)};
+  return set_position(board, words);
+}
+
+void Tournament::run_worker() {
+  AI ai_a{config_.engine_a};
+  AI ai_b{config_.engine_b};
+  while (!is_finished()) {
+    const int game_index{next_game_++};
+    if (game_index >= config_.max_games) {
+      return;
+    }
+
+    uint64_t nodes{};
+    double search_ms{};
+    bool is_time_loss{};
+    const Outcome outcome{
+        play_game(game_index, ai_a, ai_b, nodes, search_ms, is_time_loss)};
+
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    switch (outcome) {
+      case Outcome::WinA:
+        result_.wins++;
+        break;
+      case Outcome::Draw:
+        result_.draws++;
+        break;
+      case Outcome::WinB:
+        result_.losses++;
+        break;
+    }
+    result_.nodes += nodes;
+    result_.search_ms += search_ms;
+    result_.time_losses += is_time_loss ? 1 : 0;
+
+    if (result_.get_games() % 100 == 0) {
+      LOGF("SELFPLAY", "{} games: +{} ={} -{} elo {:.1f} +- {:.1f} llr {:.2f}",
+           result_.get_games(), result_.wins, result_.draws, result_.losses,
+           result_.get_elo(), result_.get_elo_error(),
+           result_.get_llr(config_.sprt));
+    }
+  }
+}
+
+Tournament::Outcome Tournament::play_game(int game_index, AI& ai_a, AI& ai_b,
+                                          uint64_t& nodes,
+                                          double& search_ms,
+                                          bool& is_time_loss) {
+  const std::string& opening{
+      config_.openings[static_cast<size_t>(game_index / 2) %
+                       config_.openings.size()]};
+  // Engine A plays white in even games and black in odd ones
+  const PieceColor color_a{game_index % 2 == 0 ? PieceColor::White
+                                               : PieceColor::Black};
+
+  Board board;
+  // run() checked every opening
+  [[maybe_unused]] const bool is_valid{!set_opening(board, opening)};
+  assert(is_valid);
+
+  ai_a.clear();
+  ai_b.clear();
+  SearchLimits limits{config_.limits};
+  for (int ply = 0; ply < config_.max_plies; ply++) {
+    if (is_game_over(board)) {
+      break;
+    }
+    const PieceColor turn{board.get_turn()};
+    AI& ai{turn == color_a ? ai_a : ai_b};
+    const auto start{std::chrono::steady_clock::now()};
+    const SearchResult result{ai.find_best_move(board, limits)};
+    nodes += result.stats.nodes;
+    search_ms += result.stats.elapsed_ms;
+    if (limits.has_clock(turn)) {
+      // The clock runs for the whole call, not just the search
+      std::chrono::milliseconds& clock{limits.clock[get_color_index(turn)]};
+      clock -= std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start);
+      if (clock.count() <= 0) {
+        is_time_loss = true;
+        break;
+      }
+      clock += limits.increment[get_color_index(turn)];
+    }
+    board.make_move(result.best_move);
+  }
+
+  GameRecord record{
+      make_game_record(board, get_start_fen(split_words(opening)))};
+  Outcome outcome{Outcome::Draw};
+  if (is_time_loss) {
+    // The side to move flagged before making its move
+    outcome = board.get_turn() == color_a ? Outcome::WinB : Outcome::WinA;
+    record.result = board.get_turn() == PieceColor::White
+                        ? GameResult::BlackWins
+                        : GameResult::WhiteWins;
+  } else if (board.is_repetition_draw()) {
+    record.result = GameResult::Draw;
+  } else if (is_game_over(board)) {
+    // Whoever moved last has won
+    outcome = board.get_turn() == color_a ? Outcome::WinB : Outcome::WinA;
+    record.result = board.get_turn() == PieceColor::White
+                        ? GameResult::BlackWins
+                        : GameResult::WhiteWins;
+  } else {
+    // Adjudicated once the ply limit is hit
+    record.result = GameResult::Draw;
+  }
+  if (records_.is_open()) {
+    records_.write(record);
+  }
+  return outcome;
+}
+
+bool Tournament::is_finished() const {
+  std::lock_guard<std::mutex> lock(result_mutex_);
+  const double llr{result_.get_llr(config_.sprt)};
+  return llr <= config_.sprt.get_lower_bound() ||
+         llr >= config_.sprt.get_upper_bound();
+}
@@ -0,0 +1,167 @@
+#include "transposition_table.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "log.hpp"
+
+static_assert(std::endian::native == std::endian::little,
+              "table files are read as little-endian arrays");
+static_assert(sizeof(TTEntry) == 16 && std::is_trivially_copyable_v<TTEntry>);
+
+namespace {
+constexpr std::string_view k_magic{"CPTT"};
+constexpr uint32_t k_version{1};
+
+// Entries start one cache line into files, so they stay aligned
+struct FileHeader {
+  std::array<char, 4> magic;
+  uint32_t version;
+  uint64_t entry_count;
+};
+constexpr size_t k_header_size{64};
+static_assert(sizeof(FileHeader) <= k_header_size);
+
+FileHeader make_header(size_t entry_count) {
+  FileHeader header{};
+  std::copy(k_magic.begin(), k_magic.end(), header.magic.begin());
+  header.version = k_version;
+  header.entry_count = entry_count;
+  return header;
+}
+
+bool is_valid_header(const FileHeader& header) {
+  return std::string_view{header.magic.data(), header.magic.size()} ==
+             k_magic &&
+         header.version == k_version;
+}
+}  // namespace
+
+TranspositionTable::TranspositionTable(size_t size_mb,
+                                       const std::string& path) {
+  if (path.empty() || !map_file(path, size_mb)) {
+    resize(size_mb);
+  }
+}
+
+size_t TranspositionTable::get_entry_count(size_t size_mb) {
+  return std::bit_floor(size_mb * 1024 * 1024 / sizeof(TTEntry));
+}
+
+void TranspositionTable::set_memory(PageMemory memory, size_t offset) {
+  memory_ = std::move(memory);
+  entries_ = reinterpret_cast<TTEntry*>(memory_.get_data() + offset);
+  mask_ = (memory_.get_size() - offset) / sizeof(TTEntry) - 1;
+}
+
+void TranspositionTable::resize(size_t size_mb) {
+  const size_t count{get_entry_count(size_mb)};
+  PageMemory memory;
+  if (!memory.allocate(count * sizeof(TTEntry))) {
+    throw std::bad_alloc{};
+  }
+  set_memory(std::move(memory), 0);
+  clear();
+}
+
+bool TranspositionTable::map_file(const std::string& path, size_t size_mb) {
+  const size_t count{get_entry_count(size_mb)};
+  PageMemory memory;
+  if (!memory.map_file(path, k_header_size + count * sizeof(TTEntry))) {
+    LOGF("AI", "Failed to map hash file {}", path);
+    return false;
+  }
+
+  FileHeader header{};
+  std::memcpy(&header, memory.get_data(), sizeof(header));
+  const bool is_warm{is_valid_header(header) && header.entry_count == count};
+  header = make_header(count);
+  std::memcpy(memory.get_data(), &header, sizeof(header));
+  set_memory(std::move(memory), k_header_size);
+  if (!is_warm) {
+    clear();
+  }
+  LOGF("AI", "Hash file {} mapped, {} entries, {}", path, count,
+       is_warm ? "warm" : "cold");
+  return true;
+}
+
+void TranspositionTable::clear() {
+  std::fill(entries_, entries_ + get_entry_count(), TTEntry{});
+}
+
+bool TranspositionTable::save(const std::string& path) const {
+  std::ofstream file{path, std::ios::binary};
+  std::array<char, k_header_size> header{};
+  const FileHeader file_header{make_header(get_entry_count())};
+  std::memcpy(header.data(), &file_header, sizeof(file_header));
+  file.write(header.data(), static_cast<std::streamsize>(header.size()));
+  file.write(reinterpret_cast<const char*>(entries_),
+             static_cast<std::streamsize>(get_entry_count() * sizeof(TTEntry)));
+  return file.good();
+}
+
+bool TranspositionTable::load(const std::string& path) {
+  std::ifstream file{path, std::ios::binary};
+  std::array<char, k_header_size> header_data{};
+  file.read(header_data.data(),
+            static_cast<std::streamsize>(header_data.size()));
+  FileHeader header{};
+  std::memcpy(&header, header_data.data(), sizeof(header));
+  if (!file || !is_valid_header(header)) {
+    LOGF("AI", "{} is not a version {} hash snapshot", path, k_version);
+    return false;
+  }
+
+  // Read in chunks so large snapshots need no second table in memory
+  std::vector<TTEntry> chunk(size_t{1} << 16);
+  for (uint64_t remaining = header.entry_count; remaining > 0;) {
+    const size_t count{std::min<uint64_t>(remaining, chunk.size())};
+    file.read(reinterpret_cast<char*>(chunk.data()),
+              static_cast<std::streamsize>(count * sizeof(TTEntry)));
+    if (!file) {
+      LOGF("AI", "{} is truncated", path);
+      return false;
+    }
+    for (const TTEntry& entry : std::span{chunk}.first(count)) {
+      TTEntry& slot{entries_[get_index(entry.key)]};
+      if (entry.bound != Bound::None &&
+          (slot.bound == Bound::None || slot.depth <= entry.depth)) {
+        slot = entry;
+      }
+    }
+    remaining -= count;
+  }
+  return true;
+}
+
+const TTEntry* TranspositionTable::probe(uint64_t key) const {
+  const TTEntry& entry{entries_[get_index(key)]};
+  return entry.bound != Bound::None && entry.key == key ? &entry : nullptr;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, int score, Bound bound,
+                               Move move) {
+  TTEntry& entry{entries_[get_index(key)]};
+  // Keep the deeper result of the same position unless the new one is exact
+  if (entry.key == key && entry.depth > depth && bound != Bound::Exact) {
+    return;
+  }
+  if (move.tile == -1 && entry.key == key) {
+    move = entry.get_move();
+  }
+  entry = {key,
+           static_cast<int16_t>(score),
+           static_cast<int8_t>(move.tile),
+           static_cast<int8_t>(move.target),
+           static_cast<uint8_t>(depth),
+           bound};
+}
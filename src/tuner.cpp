@@ -0,0 +1,214 @@
+#include "tuner.hpp"
+
+#include <cmath>
+#include <format>
+#include <thread>
+
+#include "evaluation.hpp"
+#include "game_record.hpp"
+#include "log.hpp"
+
+namespace {
+constexpr size_t k_pst_size{64};
+constexpr size_t k_straggler_index{64};
+}  // namespace
+
+Tuner::Tuner(TunerConfig config) : config_{std::move(config)} {
+  for (size_t tile = 0; tile < k_pst_size; tile++) {
+    weights_[tile] = k_pst[tile];
+  }
+  weights_[k_straggler_index] = k_straggler_weight;
+}
+
+bool Tuner::load() {
+  const bool is_loaded{for_each_position(
+      config_.record_paths, config_.skip_plies,
+      [this](const Board& board, float result) {
+        add_position(board, result);
+      })};
+  LOGF("TUNER", "{} positions loaded", results_.size());
+  return is_loaded && !results_.empty();
+}
+
+void Tuner::add_position(const Board& board, float result) {
+  std::array<int8_t, k_pst_size> features{};
+  int white_straggler{};
+  int black_straggler{};
+  for (int tile = 0; tile < 64; tile++) {
+    switch (const PieceColor color{board.get_color(tile)}) {
+      case PieceColor::White:
+        features[static_cast<size_t>(tile)]++;
+        white_straggler = std::max(white_straggler,
+                                   get_straggler_distance(color, tile));
+        break;
+      case PieceColor::Black:
+        features[static_cast<size_t>(transpose_tile(tile))]--;
+        black_straggler = std::max(black_straggler,
+                                   get_straggler_distance(color, tile));
+        break;
+      default:
+        break;
+    }
+  }
+  features_.insert(features_.end(), features.begin(), features.end());
+  stragglers_.push_back(static_cast<int8_t>(black_straggler - white_straggler));
+  results_.push_back(result);
+}
+
+double Tuner::compute_loss(const Weights& weights, double scale,
+                           Weights* gradient) const {
+  // The hot loops run in float over plain arrays so the compiler can
+  // vectorize them; every thread reduces its own share
+  std::array<float, k_pst_size> pst{};
+  for (size_t tile = 0; tile < k_pst_size; tile++) {
+    pst[tile] = static_cast<float>(weights[tile]);
+  }
+  const auto straggler_weight{static_cast<float>(weights[k_straggler_index])};
+  const auto sigmoid_scale{static_cast<float>(scale)};
+
+  const size_t thread_count{std::max<size_t>(config_.threads, 1)};
+  const size_t count{results_.size()};
+  std::vector<double> losses(thread_count);
+  std::vector<Weights> gradients(thread_count);
+  {
+    std::vector<std::jthread> threads;
+    for (size_t thread = 0; thread < thread_count; thread++) {
+      threads.emplace_back([&, thread] {
+        const size_t begin{count * thread / thread_count};
+        const size_t end{count * (thread + 1) / thread_count};
+        std::array<float, k_pst_size> pst_gradient{};
+        float straggler_gradient{};
+        double loss{};
+        for (size_t i = begin; i < end; i++) {
+          const int8_t* features{&features_[i * k_pst_size]};
+          // Eight independent partial sums vectorize without fast-math
+          std::array<float, 8> lanes{};
+          for (size_t tile = 0; tile < k_pst_size; tile += 8) {
+            for (size_t lane = 0; lane < 8; lane++) {
+              lanes[lane] += features[tile + lane] * pst[tile + lane];
+            }
+          }
+          float evaluation{straggler_weight * stragglers_[i]};
+          for (const float lane : lanes) {
+            evaluation += lane;
+          }
+
+          const float prediction{
+              1.0F / (1.0F + std::exp(-sigmoid_scale * evaluation))};
+          const float error{prediction - results_[i]};
+          loss += static_cast<double>(error * error);
+          if (gradient == nullptr) {
+            continue;
+          }
+          const float factor{error * prediction * (1.0F - prediction)};
+          for (size_t tile = 0; tile < k_pst_size; tile++) {
+            pst_gradient[tile] += factor * features[tile];
+          }
+          straggler_gradient += factor * stragglers_[i];
+        }
+
+        losses[thread] = loss;
+        for (size_t tile = 0; tile < k_pst_size; tile++) {
+          gradients[thread][tile] = pst_gradient[tile];
+        }
+        gradients[thread][k_straggler_index] = straggler_gradient;
+      });
+    }
+  }
+
+  double loss{};
+  for (size_t thread = 0; thread < thread_count; thread++) {
+    loss += losses[thread];
+  }
+  if (gradient != nullptr) {
+    const double factor{2.0 * scale / static_cast<double>(count)};
+    gradient->fill(0.0);
+    for (const Weights& thread_gradient : gradients) {
+      for (size_t i = 0; i < k_weight_count; i++) {
+        (*gradient)[i] += thread_gradient[i] * factor;
+      }
+    }
+  }
+  return loss / static_cast<double>(count);
+}
+
+void Tuner::fit_scale() {
+  // Golden-section search on a log scale
+  constexpr double k_ratio{0.6180339887498949};
+  double low{std::log(1e-4)};
+  double high{std::log(1.0)};
+  for (int i = 0; i < 40; i++) {
+    const double left{high - k_ratio * (high - low)};
+    const double right{low + k_ratio * (high - low)};
+    if (compute_loss(weights_, std::exp(left), nullptr) <
+        compute_loss(weights_, std::exp(right), nullptr)) {
+      high = right;
+    } else {
+      low = left;
+    }
+  }
+  scale_ = std::exp((low + high) / 2.0);
+  LOGF("TUNER", "sigmoid scale {:.6f}, loss {:.6f}", scale_,
+       compute_loss(weights_, scale_, nullptr));
+}
+
+double Tuner::tune() {
+  constexpr double k_beta1{0.9};
+  constexpr double k_beta2{0.999};
+  constexpr double k_epsilon{1e-8};
+
+  Weights gradient{};
+  Weights momentum{};
+  Weights velocity{};
+  double loss{};
+  for (int iteration = 1; iteration <= config_.iterations; iteration++) {
+    loss = compute_loss(weights_, scale_, &gradient);
+    const double correction1{1.0 - std::pow(k_beta1, iteration)};
+    const double correction2{1.0 - std::pow(k_beta2, iteration)};
+    for (size_t i = 0; i < k_weight_count; i++) {
+      momentum[i] = k_beta1 * momentum[i] + (1.0 - k_beta1) * gradient[i];
+      velocity[i] = k_beta2 * velocity[i] +
+                    (1.0 - k_beta2) * gradient[i] * gradient[i];
+      weights_[i] -= config_.learning_rate * (momentum[i] / correction1) /
+                     (std::sqrt(velocity[i] / correction2) + k_epsilon);
+    }
+    if (iteration % 50 == 0) {
+      LOGF("TUNER", "iteration {} loss {:.6f}", iteration, loss);
+    }
+  }
+  return compute_loss(weights_, scale_, nullptr);
+}
+
+std::string Tuner::generate_header(double loss) const {
+  std::string header{std::format(
+      "#pragma once\n"
+      "\n"
+      "#include <array>\n"
+      "\n"
+      "// Evaluation weights, written by cornerpawns-tuner. Rerun the tuner "
+      "rather\n"
+      "// than editing the values by hand.\n"
+      "// Tuned on {} positions, loss {:.6f}\n"
+      "\n"
+      "// Penalty per tile the furthest-lagging pawn still has to travel\n"
+      "inline constexpr int k_straggler_weight{{{}}};\n"
+      "\n"
+      "// Pawn values by tile from White's point of view, tile 0 being a1; "
+      "Black\n"
+      "// reads the table transposed, see get_pst_value()\n"
+      "// clang-format off\n"
+      "inline constexpr std::array<int, 64> k_pst{{\n",
+      results_.size(), loss,
+      std::lround(weights_[k_straggler_index]))};
+  for (size_t row = 0; row < 8; row++) {
+    header += ' ';
+    for (size_t column = 0; column < 8; column++) {
+      header += std::format("{:>4},", std::lround(weights_[row * 8 + column]));
+    }
+    header += '\n';
+  }
+  header +=
+      "};\n"
+      "// clang-format on\n";
+  return header;
+}
@@ -0,0 +1,33 @@
+#include <format>
+#include <iostream>
+#include <string>
+
+#include "engine.hpp"
+#include "protocol.hpp"
+
+// cornerpawns-engine [<option>=<value>...], e.g. hash=256 hash_file=tt.bin
+
+int main(int argc, char* argv[]) {
+  SearchOptions options;
+  for (int i = 1; i < argc; i++) {
+    const std::string_view assignment{argv[i]};
+    const size_t equals{assignment.find('=')};
+    if (equals == std::string_view::npos) {
+      std::cerr << std::format("expected <name>=<value>, got {}\n",
+                               assignment);
+      return 1;
+    }
+    if (const auto error =
+            set_search_option(options, assignment.substr(0, equals),
+                              assignment.substr(equals + 1))) {
+      std::cerr << *error << '\n';
+      return 1;
+    }
+  }
+
+  Engine engine{std::cout, options};
+  std::string line;
+  while (std::getline(std::cin, line) && engine.execute(line)) {
+  }
+  return 0;
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "board.hpp"
+#include "protocol.hpp"
+#include "socket.hpp"
+
+// Local load generator for cornerpawns-server. Every connection plays its
+// games concurrently (one request in flight per game) and the latency from
+// sending "go" to receiving "bestmove" is recorded for every move.
+//
+// Usage: cornerpawns-loadgen [port] [connections] [games per connection]
+//                            [plies per game] [movetime ms]
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+  uint16_t port{7777};
+  int connections{4};
+  int games{8};
+  int plies{40};
+  int movetime{20};
+};
+
+struct LoadGame {
+  Board board;
+  std::string moves;
+  int plies{};
+  Clock::time_point sent;
+  bool is_finished{};
+};
+
+template <typename T>
+T parse_arg(int argc, char* argv[], int index, T fallback) {
+  if (index >= argc) {
+    return fallback;
+  }
+  const std::string_view text{argv[index]};
+  T value{};
+  const auto [ptr, error]{
+      std::from_chars(text.data(), text.data() + text.size(), value)};
+  return error == std::errc{} ? value : fallback;
+}
+
+class Client {
+ public:
+  Client(Socket socket, const Config& config)
+      : socket_{std::move(socket)}, config_{config} {}
+
+  /// <summary>
+  /// Plays every game to the end and returns the latencies in microseconds
+  /// </summary>
+  std::vector<int64_t> run() {
+    for (int i = 0; i < config_.games; i++) {
+      send("new");
+      const std::vector<std::string_view> reply_words{
+          split_words(read_line())};
+      const std::optional<int> id{
+          reply_words.empty() ? std::nullopt : parse_int(reply_words[0])};
+      if (!id) {
+        std::cerr << "failed to create game\n";
+        return latencies_;
+      }
+      games_.try_emplace(*id);
+    }
+
+    for (auto& [id, game] : games_) {
+      request_move(id, game);
+    }
+    while (active_games_ > 0) {
+      handle_reply(read_line());
+    }
+    for (const auto& [id, game] : games_) {
+      send(std::format("{} close", id));
+    }
+    return latencies_;
+  }
+
+ private:
+  void request_move(int id, LoadGame& game) {
+    active_games_++;
+    send(std::format("{} position startpos{}", id,
+                     game.moves.empty() ? "" : " moves" + game.moves));
+    game.sent = Clock::now();
+    send(std::format("{} go movetime {}", id, config_.movetime));
+  }
+
+  void handle_reply(const std::string& line) {
+    const std::vector<std::string_view> words{split_words(line)};
+    if (words.size() < 3 || words[1] != "bestmove") {
+      if (words.size() >= 2 && words[1] == "error") {
+        std::cerr << line << '\n';
+      }
+      return;
+    }
+    const std::optional<int> id{parse_int(words[0])};
+    const auto it{id ? games_.find(*id) : games_.end()};
+    if (it == games_.end()) {
+      return;
+    }
+    LoadGame& game{it->second};
+    active_games_--;
+    latencies_.push_back(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                              game.sent)
+            .count());
+
+    const std::optional<Move> move{parse_move(words[2])};
+    if (!move) {
+      return;
+    }
+    game.board.make_move(*move);
+    game.moves += ' ' + move_to_string(*move);
+    if (++game.plies < config_.plies && !game.board.is_in_checkmate() &&
+        !game.board.is_draw()) {
+      request_move(it->first, game);
+    }
+  }
+
+  void send(const std::string& line) {
+    if (!socket_.send_all(line + '\n')) {
+      throw std::runtime_error{"connection lost"};
+    }
+  }
+
+  std::string read_line() {
+    while (true) {
+      if (std::optional<std::string> line = lines_.next_line()) {
+        return *line;
+      }
+      std::array<char, 4096> buffer{};
+      const int size{
+          socket_.receive(buffer.data(), static_cast<int>(buffer.size()))};
+      if (size <= 0) {
+        throw std::runtime_error{"connection lost"};
+      }
+      lines_.append({buffer.data(), static_cast<size_t>(size)});
+    }
+  }
+
+  Socket socket_;
+  const Config& config_;
+  LineBuffer lines_;
+  std::map<int, LoadGame> games_;
+  int active_games_{};
+  std::vector<int64_t> latencies_;
+};
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Config config;
+  config.port = parse_arg(argc, argv, 1, config.port);
+  config.connections = parse_arg(argc, argv, 2, config.connections);
+  config.games = parse_arg(argc, argv, 3, config.games);
+  config.plies = parse_arg(argc, argv, 4, config.plies);
+  config.movetime = parse_arg(argc, argv, 5, config.movetime);
+
+  if (!Socket::init()) {
+    return 1;
+  }
+
+  std::mutex latencies_mutex;
+  std::vector<int64_t> latencies;
+  const Clock::time_point start{Clock::now()};
+  {
+    std::vector<std::jthread> clients;
+    for (int i = 0; i < config.connections; i++) {
+      clients.emplace_back([&] {
+        std::optional<Socket> socket{Socket::connect("127.0.0.1", config.port)};
+        if (!socket) {
+          std::cerr << "failed to connect\n";
+          return;
+        }
+        try {
+          std::vector<int64_t> client_latencies{
+              Client{std::move(*socket), config}.run()};
+          std::lock_guard<std::mutex> lock(latencies_mutex);
+          latencies.insert(latencies.end(), client_latencies.begin(),
+                           client_latencies.end());
+        } catch (const std::runtime_error& error) {
+          std::cerr << error.what() << '\n';
+        }
+      });
+    }
+  }
+  const std::chrono::duration<double> elapsed{Clock::now() - start};
+
+  if (latencies.empty()) {
+    std::cout << "no moves completed\n";
+    return 1;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double fraction) {
+    const auto index{static_cast<size_t>(
+        fraction * static_cast<double>(latencies.size() - 1))};
+    return static_cast<double>(latencies[index]) / 1000.0;
+  };
+  std::cout << std::format(
+      "{} games, {} moves in {:.2f} s: {:.1f} moves/s, latency p50 {:.1f} ms "
+      "p99 {:.1f} ms max {:.1f} ms\n",
+      config.connections * config.games, latencies.size(), elapsed.count(),
+      static_cast<double>(latencies.size()) / elapsed.count(),
+      percentile(0.5), percentile(0.99), percentile(1.0));
+  return 0;
+}
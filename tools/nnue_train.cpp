@@ -0,0 +1,91 @@
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <iostream>
+
+#include "ai.hpp"
+#include "nnue_trainer.hpp"
+#include "protocol.hpp"
+
+// Trains the NNUE evaluator on recorded games:
+//   cornerpawns-nnue-train <record file>... [--epochs <n>] [--batch <n>]
+//                          [--rate <x>] [--skip <plies>] [--scale <x>]
+//                          [--out <file>]
+// The network is written quantized, ready for the search option nnue=<file>.
+
+namespace {
+template <typename T>
+bool parse_number(std::string_view text, T& value) {
+  const auto [ptr, error]{
+      std::from_chars(text.data(), text.data() + text.size(), value)};
+  return error == std::errc{} && ptr == text.data() + text.size();
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  NnueTrainerConfig config;
+  std::string output_path{"cornerpawns.nnue"};
+
+  for (int i = 1; i < argc; i++) {
+    const std::string_view arg{argv[i]};
+    if (!arg.starts_with("--")) {
+      config.record_paths.emplace_back(arg);
+      continue;
+    }
+    const std::string_view value{i + 1 < argc ? argv[++i] : ""};
+    bool is_valid{true};
+    if (arg == "--out") {
+      output_path = value;
+    } else if (arg == "--epochs") {
+      is_valid = parse_number(value, config.epochs);
+    } else if (arg == "--batch") {
+      is_valid = parse_number(value, config.batch_size) &&
+                 config.batch_size != 0;
+    } else if (arg == "--rate") {
+      is_valid = parse_number(value, config.learning_rate);
+    } else if (arg == "--skip") {
+      is_valid = parse_number(value, config.skip_plies);
+    } else if (arg == "--scale") {
+      is_valid = parse_number(value, config.eval_scale);
+    } else {
+      is_valid = false;
+    }
+    if (!is_valid) {
+      std::cerr << std::format("bad argument {} {}\n", arg, value);
+      return 1;
+    }
+  }
+  if (config.record_paths.empty()) {
+    std::cerr << "usage: cornerpawns-nnue-train <record file>... "
+                 "[--epochs <n>] [--batch <n>] [--rate <x>] [--skip <plies>] "
+                 "[--scale <x>] [--out <file>]\n";
+    return 1;
+  }
+
+  const auto start{std::chrono::steady_clock::now()};
+  NnueTrainer trainer{config};
+  if (!trainer.load()) {
+    return 1;
+  }
+  const double loss{trainer.train()};
+
+  Nnue nnue;
+  nnue.set_parameters(trainer.quantize());
+  if (!nnue.save(output_path)) {
+    std::cerr << std::format("failed to write {}\n", output_path);
+    return 1;
+  }
+
+  // Quantization error on the start position
+  Board board;
+  board.set_nnue(&nnue);
+  std::cout << std::format(
+      "{} positions, loss {:.6f}, {:.1f} s, written to {}\n"
+      "start position: float {:.1f} quantized {}\n",
+      trainer.get_position_count(), loss,
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count(),
+      output_path, trainer.evaluate(board),
+      nnue.evaluate(board.get_nnue_accumulator(), board.get_turn()));
+  return 0;
+}
@@ -0,0 +1,86 @@
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <thread>
+
+#include "position_db.hpp"
+#include "protocol.hpp"
+
+// Builds and queries position databases:
+//   cornerpawns-positiondb build <db> <record file>... [--threads <n>]
+//                                [--plies <n>]
+//   cornerpawns-positiondb query <db> startpos|fen <fen> [moves ...]
+
+namespace {
+int build(std::span<char*> args) {
+  PositionDbBuildConfig config;
+  config.output_path = args[0];
+  config.threads = std::thread::hardware_concurrency();
+  for (size_t i = 1; i < args.size(); i++) {
+    const std::string_view arg{args[i]};
+    if ((arg == "--threads" || arg == "--plies") && i + 1 < args.size()) {
+      const std::optional<int> value{parse_int(args[++i])};
+      if (!value || *value <= 0) {
+        std::cerr << std::format("bad value for {}\n", arg);
+        return 1;
+      }
+      if (arg == "--threads") {
+        config.threads = static_cast<size_t>(*value);
+      } else {
+        config.max_plies = *value;
+      }
+    } else {
+      config.record_paths.emplace_back(arg);
+    }
+  }
+
+  const auto start{std::chrono::steady_clock::now()};
+  if (!build_position_db(config)) {
+    return 1;
+  }
+  std::cout << std::format("built {} in {:.2f} s\n", config.output_path,
+                           std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count());
+  return 0;
+}
+
+int query(std::span<char*> args) {
+  PositionDb db;
+  if (!db.open(args[0])) {
+    return 1;
+  }
+  std::vector<std::string_view> words(args.begin() + 1, args.end());
+  Board board;
+  if (const auto error = set_position(board, words)) {
+    std::cerr << *error << '\n';
+    return 1;
+  }
+
+  const std::span<const PositionStats> moves{db.find(board.get_hash())};
+  std::cout << std::format("{} moves in a table of {} entries\n", moves.size(),
+                           db.get_size());
+  for (const PositionStats& stats : moves) {
+    std::cout << std::format("{} games {} +{} ={} -{} score {:.1f}%\n",
+                             move_to_string(stats.get_move()),
+                             stats.get_count(), stats.wins, stats.draws,
+                             stats.losses, 100.0 * stats.get_score());
+  }
+  return 0;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const std::span<char*> args{argv, static_cast<size_t>(argc)};
+  if (args.size() >= 4 && std::string_view{args[1]} == "build") {
+    return build(args.subspan(2));
+  }
+  if (args.size() >= 4 && std::string_view{args[1]} == "query") {
+    return query(args.subspan(2));
+  }
+  std::cerr << "usage: cornerpawns-positiondb build <db> <records>... "
+               "[--threads <n>] [--plies <n>]\n"
+               "       cornerpawns-positiondb query <db> startpos|fen <fen> "
+               "[moves ...]\n";
+  return 1;
+}
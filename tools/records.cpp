@@ -0,0 +1,58 @@
+#include <chrono>
+#include <format>
+#include <iostream>
+
+#include "game_record.hpp"
+
+// Summarizes a game record file: cornerpawns-records <file> [--replay]
+// With --replay every game is also played out on a board, which checks that
+// every recorded move is legal.
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "usage: cornerpawns-records <file> [--replay]\n";
+    return 1;
+  }
+  const bool is_replaying{argc > 2 && std::string_view{argv[2]} == "--replay"};
+
+  const auto start{std::chrono::steady_clock::now()};
+  GameRecordReader reader;
+  if (!reader.open(argv[1])) {
+    return 1;
+  }
+
+  std::array<size_t, 4> results{};
+  size_t moves{};
+  size_t illegal_games{};
+  Board board;
+  for (size_t i = 0; i < reader.get_size(); i++) {
+    const GameView game{reader.get_game(i)};
+    results[static_cast<size_t>(game.get_result())]++;
+    moves += game.get_move_count();
+    if (!is_replaying) {
+      continue;
+    }
+    if (!game.replay(board)) {
+      illegal_games++;
+    }
+  }
+  const double elapsed_s{std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count()};
+
+  const size_t games{reader.get_size()};
+  std::cout << std::format(
+      "games {} white {} black {} draw {} unfinished {}\n"
+      "moves {} ({:.1f} per game), read in {:.3f} s\n",
+      games, results[static_cast<size_t>(GameResult::WhiteWins)],
+      results[static_cast<size_t>(GameResult::BlackWins)],
+      results[static_cast<size_t>(GameResult::Draw)],
+      results[static_cast<size_t>(GameResult::None)], moves,
+      games != 0 ? static_cast<double>(moves) / static_cast<double>(games)
+                 : 0.0,
+      elapsed_s);
+  if (is_replaying) {
+    std::cout << std::format("games with illegal moves {}\n", illegal_games);
+  }
+  return illegal_games == 0 ? 0 : 1;
+}
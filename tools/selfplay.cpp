@@ -0,0 +1,170 @@
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <iostream>
+
+#include "protocol.hpp"
+#include "tournament.hpp"
+
+// Plays two engine configurations against each other and stops on an SPRT
+// verdict. Options:
+//   --games <n>           maximum number of games (default 2000)
+//   --threads <n>         concurrent games (default: one per core)
+//   --depth <n>           fixed depth per move
+//   --movetime <ms>       fixed time per move (default 20)
+//   --tc <ms>[+<ms>]      game clock per side plus increment per move;
+//                         running out of time loses
+//   --plies <n>           adjudicate a draw after this many plies
+//   --repetitions <n>     draw once a position occurs n times (default 3,
+//                         0 turns the rule off)
+//   --jumps on|off        leapfrog variant with chained jumps (default off)
+//   --openings <file>     one "startpos|fen ... [moves ...]" line per opening
+//   --random-openings <n> otherwise generate n openings of 4 random plies
+//   --seed <n>            seed for the random openings
+//   --elo0/--elo1/--alpha/--beta <x>  SPRT parameters
+//   --record <file>       append every game to a binary game record file
+//   --a <name>=<value>    search option of engine A, e.g. --a lmr=off
+//   --b <name>=<value>    search option of engine B
+
+namespace {
+template <typename T>
+bool parse_number(std::string_view text, T& value) {
+  const auto [ptr, error]{
+      std::from_chars(text.data(), text.data() + text.size(), value)};
+  return error == std::errc{} && ptr == text.data() + text.size();
+}
+
+bool set_engine_option(SearchOptions& options, std::string_view assignment) {
+  const size_t equals{assignment.find('=')};
+  if (equals == std::string_view::npos) {
+    std::cerr << std::format("expected <name>=<value>, got {}\n", assignment);
+    return false;
+  }
+  if (const auto error =
+          set_search_option(options, assignment.substr(0, equals),
+                            assignment.substr(equals + 1))) {
+    std::cerr << *error << '\n';
+    return false;
+  }
+  return true;
+}
+
+std::vector<std::string> load_openings(const std::string& path) {
+  std::vector<std::string> openings;
+  std::ifstream file{path};
+  std::string line;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line[0] != '#') {
+      openings.push_back(line);
+    }
+  }
+  return openings;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  TournamentConfig config;
+  config.threads = std::thread::hardware_concurrency();
+  config.limits.movetime = std::chrono::milliseconds{20};
+  std::string openings_path;
+  int random_openings{500};
+  uint64_t seed{1};
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string_view name{argv[i]};
+    const std::string_view value{argv[i + 1]};
+    int depth{};
+    int movetime{};
+    bool is_valid{true};
+    if (name == "--games") {
+      is_valid = parse_number(value, config.max_games);
+    } else if (name == "--threads") {
+      is_valid = parse_number(value, config.threads);
+    } else if (name == "--depth") {
+      is_valid = parse_number(value, depth);
+      config.limits = {depth, {}};
+    } else if (name == "--movetime") {
+      is_valid = parse_number(value, movetime);
+      config.limits = {0, std::chrono::milliseconds{movetime}};
+    } else if (name == "--tc") {
+      const size_t plus{value.find('+')};
+      int base{};
+      int increment{};
+      is_valid = parse_number(value.substr(0, plus), base) && base > 0 &&
+                 (plus == std::string_view::npos ||
+                  parse_number(value.substr(plus + 1), increment));
+      config.limits = {};
+      config.limits.clock.fill(std::chrono::milliseconds{base});
+      config.limits.increment.fill(std::chrono::milliseconds{increment});
+    } else if (name == "--plies") {
+      is_valid = parse_number(value, config.max_plies);
+    } else if (name == "--repetitions") {
+      is_valid = parse_number(value, config.repetition_limit) &&
+                 config.repetition_limit >= 0;
+    } else if (name == "--jumps") {
+      is_valid = value == "on" || value == "off";
+      config.jumps = value == "on";
+    } else if (name == "--openings") {
+      openings_path = value;
+    } else if (name == "--random-openings") {
+      is_valid = parse_number(value, random_openings);
+    } else if (name == "--seed") {
+      is_valid = parse_number(value, seed);
+    } else if (name == "--elo0") {
+      is_valid = parse_number(value, config.sprt.elo0);
+    } else if (name == "--elo1") {
+      is_valid = parse_number(value, config.sprt.elo1);
+    } else if (name == "--alpha") {
+      is_valid = parse_number(value, config.sprt.alpha);
+    } else if (name == "--beta") {
+      is_valid = parse_number(value, config.sprt.beta);
+    } else if (name == "--record") {
+      config.record_path = value;
+    } else if (name == "--a") {
+      is_valid = set_engine_option(config.engine_a, value);
+    } else if (name == "--b") {
+      is_valid = set_engine_option(config.engine_b, value);
+    } else {
+      is_valid = false;
+    }
+    if (!is_valid) {
+      std::cerr << std::format("bad argument {} {}\n", name, value);
+      return 1;
+    }
+  }
+
+  config.openings = openings_path.empty()
+                        ? Tournament::generate_openings(random_openings, 4,
+                                                        seed)
+                        : load_openings(openings_path);
+  std::cout << std::format("{} games max on {} threads, {} openings\n",
+                           config.max_games, config.threads,
+                           config.openings.size());
+
+  const SprtConfig sprt{config.sprt};
+  const std::optional<TournamentResult> played{
+      Tournament{std::move(config)}.run()};
+  if (!played) {
+    return 1;
+  }
+  const TournamentResult& result{*played};
+
+  const double llr{result.get_llr(sprt)};
+  std::string_view verdict{"inconclusive"};
+  if (llr >= sprt.get_upper_bound()) {
+    verdict = "H1 accepted (A is stronger)";
+  } else if (llr <= sprt.get_lower_bound()) {
+    verdict = "H0 accepted (A is not stronger)";
+  }
+  std::cout << std::format(
+      "games {} +{} ={} -{}\nelo {:.1f} +- {:.1f} (95%)\n"
+      "llr {:.2f} [{:.2f}, {:.2f}] {}\n"
+      "nps per thread {:.0f}, aggregate nps {:.0f}, {:.1f} s\n"
+      "losses on time {}\n",
+      result.get_games(), result.wins, result.draws, result.losses,
+      result.get_elo(), result.get_elo_error(), llr, sprt.get_lower_bound(),
+      sprt.get_upper_bound(), verdict, result.get_nps(),
+      static_cast<double>(result.nodes) * 1000.0 / result.wall_ms,
+      result.wall_ms / 1000.0, result.time_losses);
+  return 0;
+}
@@ -0,0 +1,47 @@
+#include <charconv>
+#include <string_view>
+
+#include "log.hpp"
+#include "server.hpp"
+
+namespace {
+template <typename T>
+T parse_arg(int argc, char* argv[], int index, T fallback) {
+  if (index >= argc) {
+    return fallback;
+  }
+  const std::string_view text{argv[index]};
+  T value{};
+  const auto [ptr, error]{
+      std::from_chars(text.data(), text.data() + text.size(), value)};
+  return error == std::errc{} ? value : fallback;
+}
+}  // namespace
+
+// Usage: cornerpawns-server [port] [threads] [max movetime ms]
+int main(int argc, char* argv[]) {
+  const auto port{parse_arg<uint16_t>(argc, argv, 1, 7777)};
+  const auto threads{parse_arg<size_t>(argc, argv, 2,
+                                       std::thread::hardware_concurrency())};
+  EngineService::Options options;
+  options.max_movetime = std::chrono::milliseconds{
+      parse_arg<int>(argc, argv, 3, static_cast<int>(
+                                          options.max_movetime.count()))};
+
+  if (!Socket::init()) {
+    LOG("SERVER", "Failed to initialize sockets");
+    return 1;
+  }
+  std::optional<Socket> listener{Socket::listen(port)};
+  if (!listener) {
+    LOGF("SERVER", "Failed to listen on port {}", port);
+    return 1;
+  }
+
+  ThreadPool pool{threads};
+  EngineService service{pool, options};
+  LOGF("SERVER", "Listening on 127.0.0.1:{} with {} search threads", port,
+       pool.get_size());
+  Server{service, std::move(*listener)}.run();
+  return 1;
+}
@@ -0,0 +1,78 @@
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "protocol.hpp"
+#include "tuner.hpp"
+
+// Tunes the evaluation weights on recorded games:
+//   cornerpawns-tuner <record file>... [--threads <n>] [--iterations <n>]
+//                     [--rate <x>] [--skip <plies>] [--out <pst.hpp>]
+// The tuned tables are written as a header that replaces include/pst.hpp.
+
+int main(int argc, char* argv[]) {
+  TunerConfig config;
+  config.threads = std::thread::hardware_concurrency();
+  std::string output_path{"pst.hpp"};
+
+  for (int i = 1; i < argc; i++) {
+    const std::string_view arg{argv[i]};
+    if (!arg.starts_with("--")) {
+      config.record_paths.emplace_back(arg);
+      continue;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << std::format("missing value for {}\n", arg);
+      return 1;
+    }
+    const std::string_view value{argv[++i]};
+    const std::optional<int> number{parse_int(value)};
+    if (arg == "--out") {
+      output_path = value;
+    } else if (arg == "--rate" &&
+               std::from_chars(value.data(), value.data() + value.size(),
+                               config.learning_rate)
+                       .ec == std::errc{}) {
+    } else if (number && *number >= 0 && arg == "--threads") {
+      config.threads = static_cast<size_t>(*number);
+    } else if (number && *number >= 0 && arg == "--iterations") {
+      config.iterations = *number;
+    } else if (number && *number >= 0 && arg == "--skip") {
+      config.skip_plies = *number;
+    } else {
+      std::cerr << std::format("bad argument {} {}\n", arg, value);
+      return 1;
+    }
+  }
+  if (config.record_paths.empty()) {
+    std::cerr << "usage: cornerpawns-tuner <record file>... [--threads <n>] "
+                 "[--iterations <n>] [--rate <x>] [--skip <plies>] "
+                 "[--out <pst.hpp>]\n";
+    return 1;
+  }
+
+  const auto start{std::chrono::steady_clock::now()};
+  Tuner tuner{config};
+  if (!tuner.load()) {
+    return 1;
+  }
+  tuner.fit_scale();
+  const double loss{tuner.tune()};
+
+  std::ofstream output{output_path};
+  output << tuner.generate_header(loss);
+  if (!output) {
+    std::cerr << std::format("failed to write {}\n", output_path);
+    return 1;
+  }
+  std::cout << std::format(
+      "{} positions, loss {:.6f}, {:.1f} s, tables written to {}\n",
+      tuner.get_position_count(), loss,
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count(),
+      output_path);
+  return 0;
+}